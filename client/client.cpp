@@ -12,6 +12,15 @@ async_connect_client::async_connect_client()
 
 async_connect_client::~async_connect_client()
 {
+    // a connect still in progress would otherwise start threads after they have been joined
+    if (connecting_thread_.joinable())
+    {
+        if (connecting_thread_.get_id() == std::this_thread::get_id())
+            connecting_thread_.detach();
+        else
+            connecting_thread_.join();
+    }
+
     disconnect();
 
     if (processing_thread_.joinable())
@@ -30,8 +39,11 @@ bool async_connect_client::connect(std::string_view ip, std::string_view port)
     if (connected_)
         throw exception(exception::reason_id::already_connected, "async_connect_client::connect: attempted to connect while a connection was open");
 
-    if (!process_callback_)
-        throw exception(exception::reason_id::no_callback, "async_connect_client::connect: no processing callback set");
+    if (processing_thread_.joinable())
+        processing_thread_.join();
+
+    if (receiving_thread_.joinable())
+        receiving_thread_.join();
 
     addrinfo hints = {}, *result = nullptr;
 
@@ -50,20 +62,59 @@ bool async_connect_client::connect(std::string_view ip, std::string_view port)
         throw exception(exception::reason_id::socket_failure, "async_connect_client::connect: failed to create socket");
     }
 
-    if (::connect(socket_, result->ai_addr, int(result->ai_addrlen)) == SOCKET_ERROR)
+    auto deadline = std::chrono::steady_clock::now() + connect_timeout_;
+    auto timeout_ms = connect_timeout_.count() ? static_cast<int>(connect_timeout_.count()) : -1;
+
+    if (!net::connect_within(socket_, result->ai_addr, int(result->ai_addrlen), timeout_ms))
     {
         freeaddrinfo(result);
+        closesocket(socket_);
+        socket_ = INVALID_SOCKET;
         throw exception(exception::reason_id::connection_error, "async_connect_client::connect: error connecting");
     }
 
     freeaddrinfo(result);
 
+    // the handshake gets whatever the connect left of the timeout
+    if (connect_timeout_.count())
+    {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+
+        if (remaining.count() < 1 || !net::set_io_timeout(socket_, static_cast<int>(remaining.count())))
+        {
+            disconnect_internal(disconnect_reasons::reason_handshake_fail);
+            return false;
+        }
+    }
+
     if (!perform_handshake())
     {
         disconnect_internal(disconnect_reasons::reason_handshake_fail);
         return false;
     }
 
+    int no_delay = 1;
+    setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char *>(&no_delay), sizeof(no_delay));
+
+    // from here on the engine owns the socket
+    if (!engine_.open() || !engine_.attach(socket_, server_token_))
+    {
+        engine_.close();
+        disconnect_internal(disconnect_reasons::reason_handshake_fail);
+        throw exception(exception::reason_id::event_loop_failure, "async_connect_client::connect: failed to set up io engine");
+    }
+
+    // packets sent after the previous connection went down must not reach the new one
+    outbound_packets_.consume([](std::vector<std::uint8_t> &&) {});
+
+    process_buffer_.clear();
+    received_.clear();
+    awaited_bytes_ = sizeof(packet::header);
+    receiving_in_place_ = false;
+    reading_held_ = false;
+    resume_reading_ = false;
+    signalled_ = false;
+
     connected_ = true;
     processing_thread_ = std::thread(&async_connect_client::process_data, this);
     receiving_thread_ = std::thread(&async_connect_client::receive_data, this);
@@ -71,6 +122,40 @@ bool async_connect_client::connect(std::string_view ip, std::string_view port)
     return true;
 }
 
+async_connect_client::connect_awaitable async_connect_client::async_connect(std::string_view ip, std::string_view port)
+{
+    return connect_awaitable(this, ip, port);
+}
+
+void async_connect_client::connect_awaitable::await_suspend(std::coroutine_handle<> handle)
+{
+    auto &thread = client_->connecting_thread_;
+
+    // a coroutine that failed to connect continues on the connecting thread, and may well try again from there
+    if (thread.joinable())
+    {
+        if (thread.get_id() == std::this_thread::get_id())
+            thread.detach();
+        else
+            thread.join();
+    }
+
+    // connecting blocks until the handshake is done, so it runs on a thread of its own instead of the caller's
+    thread = std::thread([this, handle]()
+                         {
+        try
+        {
+            connected_ = client_->connect(ip_, port_);
+        }
+        catch (...)
+        {
+            error_ = std::current_exception();
+        }
+
+        if (!connected_ || !client_->resume_on_processing(handle))
+            handle.resume(); });
+}
+
 void async_connect_client::disconnect()
 {
     if (connected_)
@@ -87,28 +172,79 @@ void async_connect_client::send_packet(packet::base_packet *const packet)
     if (!packet)
         throw exception(exception::reason_id::packet_nullptr, "async_connect_client::send_packet: packet was nullptr");
 
-    std::lock_guard guard(send_mtx_);
+    if (!connected_)
+        return;
+
+    // every thread serializes with its own serializer, so concurrent sends never wait on each other
+    thread_local packet::detail::serializer serializer = {};
+
+    auto encoding = packet->get_encoding();
 
-    serializer.reset();
+    serializer.begin_frame(net::buffer_pool::acquire(0), sizeof(packet::header));
+    serializer.set_encoding(encoding);
 
     packet->serialize_value(serializer);
 
-    std::vector<std::uint8_t> packet_data(sizeof(packet::header) + serializer.get_serialized_data_length());
+    auto packet_data = serializer.take_frame();
 
     packet::header packet_header = construct_packet_header(
-        serializer.get_serialized_data_length(),
+        packet_data.size() - sizeof(packet::header),
         packet->get_id(),
-        packet::flags::fl_none);
+        encoding == packet::enc_compact ? packet::flags::fl_compact : packet::flags::fl_none);
 
     memcpy(packet_data.data(), &packet_header, sizeof(packet::header));
 
-    memcpy(
-        packet_data.data() + sizeof(packet::header),
-        serializer.get_serialized_data(),
-        serializer.get_serialized_data_length());
+    queue_packet(std::move(packet_data));
+}
+
+void async_connect_client::set_max_elements(std::uint32_t max_elements)
+{
+    if (connected_)
+        throw exception(exception::reason_id::already_connected, "async_connect_client::set_max_elements: attempted to change element limit while a connection was open");
+
+    process_serializer_.set_max_elements(max_elements);
+}
+
+void async_connect_client::set_max_frame_size(std::uint32_t max_frame_size)
+{
+    if (connected_)
+        throw exception(exception::reason_id::already_connected, "async_connect_client::set_max_frame_size: attempted to change frame size limit while a connection was open");
+
+    if (max_frame_size < sizeof(packet::header))
+        throw exception(exception::reason_id::invalid_limits, "async_connect_client::set_max_frame_size: frame size limit is smaller than a header");
+
+    max_frame_size_ = max_frame_size;
+}
+
+void async_connect_client::set_inbound_limits(std::size_t low, std::size_t high)
+{
+    if (connected_)
+        throw exception(exception::reason_id::already_connected, "async_connect_client::set_inbound_limits: attempted to change inbound limits while a connection was open");
+
+    if (low > high)
+        throw exception(exception::reason_id::invalid_limits, "async_connect_client::set_inbound_limits: low watermark is above high watermark");
+
+    inbound_low_ = low;
+    inbound_high_ = high;
+}
+
+void async_connect_client::set_compression(bool enabled, std::uint32_t min_size)
+{
+    if (connected_)
+        throw exception(exception::reason_id::already_connected, "async_connect_client::set_compression: attempted to change compression while a connection was open");
 
-    if (!send_packet_internal(packet_data.data(), packet_data.size()))
-        disconnect_internal(disconnect_reasons::reason_error);
+    compression_ = enabled;
+    compression_threshold_ = min_size;
+}
+
+void async_connect_client::set_call_timeout(std::chrono::milliseconds timeout)
+{
+    call_timeout_ = timeout;
+}
+
+void async_connect_client::set_connect_timeout(std::chrono::milliseconds timeout)
+{
+    connect_timeout_ = timeout;
 }
 
 void async_connect_client::register_callback(std::function<void(async_connect_client *const, const packet::packet_id, packet::detail::serializer &)> callback_fn)
@@ -124,6 +260,16 @@ void async_connect_client::register_disconnect_callback(std::function<void(async
     on_disconnect_callback_ = callback_fn;
 }
 
+std::uint64_t async_connect_client::get_unknown_packets()
+{
+    return unknown_packets_;
+}
+
+std::size_t async_connect_client::get_pending_calls()
+{
+    return pending_call_count_.load(std::memory_order_relaxed);
+}
+
 packet::header async_connect_client::construct_packet_header(packet::packet_length length, packet::packet_id id, packet::packet_flags flags)
 {
     packet::header packet_header = {};
@@ -138,24 +284,27 @@ packet::header async_connect_client::construct_packet_header(packet::packet_leng
 
 bool async_connect_client::perform_handshake()
 {
-    packet::header packet_header = construct_packet_header(0, packet::ids::id_handshake, packet::flags::fl_handshake_cl);
+    std::uint32_t features = packet::features::ft_none;
 
-    auto buffer = reinterpret_cast<char *>(&packet_header);
+    if (compression_)
+        features |= packet::features::ft_compression;
 
-    if (!send_packet_internal(&packet_header, sizeof(packet::header)))
-        return false;
+    compressing_ = false;
 
-    int bytes_received = 0;
+    // without features the handshake stays a bare header, which servers that predate them still accept
+    std::uint8_t offer[sizeof(packet::header) + sizeof(features)] = {};
+    packet::packet_length offer_length = features ? sizeof(offer) : sizeof(packet::header);
 
-    do
-    {
-        int received = recv(socket_, buffer + bytes_received, sizeof(packet::header) - bytes_received, 0);
+    packet::header packet_header = construct_packet_header(offer_length - sizeof(packet::header), packet::ids::id_handshake, packet::flags::fl_handshake_cl);
 
-        if (received <= 0)
-            return false;
+    memcpy(offer, &packet_header, sizeof(packet::header));
+    memcpy(offer + sizeof(packet::header), &features, sizeof(features));
 
-        bytes_received += received;
-    } while (bytes_received < sizeof(packet::header));
+    if (!send_packet_internal(offer, offer_length))
+        return false;
+
+    if (!receive_packet_internal(&packet_header, sizeof(packet::header)))
+        return false;
 
     if (packet_header.flags != packet::flags::fl_handshake_sv)
         return false;
@@ -169,6 +318,23 @@ bool async_connect_client::perform_handshake()
     if (packet_header.magic != PACKET_MAGIC)
         return false;
 
+    if (!features)
+        return true;
+
+    // the server answers an offer with the features it accepted
+    std::uint32_t accepted = packet::features::ft_none;
+
+    if (!receive_packet_internal(&packet_header, sizeof(packet::header)) || !receive_packet_internal(&accepted, sizeof(accepted)))
+        return false;
+
+    if (packet_header.flags != packet::flags::fl_handshake_sv || packet_header.id != packet::ids::id_handshake)
+        return false;
+
+    if (packet_header.length != sizeof(packet::header) + sizeof(accepted) || packet_header.magic != PACKET_MAGIC)
+        return false;
+
+    compressing_ = accepted & features & packet::features::ft_compression;
+
     return true;
 }
 
@@ -181,7 +347,11 @@ bool async_connect_client::send_packet_internal(void *const data, const packet::
             socket_,
             reinterpret_cast<char *>(data) + bytes_sent,
             length - bytes_sent,
-            0);
+            MSG_NOSIGNAL);
+
+        // io_uring work of other threads in the process can interrupt these blocking calls
+        if (sent < 0 && net::last_error_interrupted())
+            continue;
 
         if (sent <= 0)
             return false;
@@ -192,110 +362,612 @@ bool async_connect_client::send_packet_internal(void *const data, const packet::
     return true;
 }
 
+bool async_connect_client::receive_packet_internal(void *const data, const packet::packet_length length)
+{
+    std::uint32_t bytes_received = 0;
+    do
+    {
+        int received = recv(
+            socket_,
+            reinterpret_cast<char *>(data) + bytes_received,
+            length - bytes_received,
+            0);
+
+        if (received < 0 && net::last_error_interrupted())
+            continue;
+
+        if (received <= 0)
+            return false;
+
+        bytes_received += received;
+    } while (bytes_received < length);
+
+    return true;
+}
+
 void async_connect_client::disconnect_internal(const disconnect_reasons reason)
 {
     std::lock_guard guard(disconnect_mtx_);
 
-    connected_ = false;
-
     switch (reason)
     {
     case disconnect_reasons::reason_handshake_fail:
-        if (socket_)
+        connected_ = false;
+
+        if (socket_ != INVALID_SOCKET)
         {
             shutdown(socket_, SD_BOTH);
             closesocket(socket_);
-            socket_ = 0;
+            socket_ = INVALID_SOCKET;
         }
         break;
     case disconnect_reasons::reason_stop:
-    {
-        packet::header packet_header = construct_packet_header(0, packet::ids::id_disconnect, packet::flags::fl_disconnect);
-        send_packet_internal(&packet_header, sizeof(packet::header));
-    }
     case disconnect_reasons::reason_error:
     case disconnect_reasons::reason_server_stop:
-        if (socket_)
+        // the receiving thread notices and tears the connection down, the processing thread drains what arrived
+        connected_ = false;
+        engine_.wake();
+        signal_processing();
+    }
+}
+
+packet::call_id async_connect_client::begin_call(packet::packet_id response_id, std::chrono::milliseconds timeout, call_completion &&complete)
+{
+    packet::call_id call = 0;
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    {
+        std::lock_guard guard(calls_mtx_);
+
+        // checked under the lock, the processing thread aborts every registered call after it saw the disconnect
+        if (connected_)
         {
-            shutdown(socket_, SD_BOTH);
-            closesocket(socket_);
-            socket_ = 0;
+            // 0 is never used, and an id is skipped if a call from before the counter wrapped around is still waiting
+            do
+                next_call_++;
+            while (!next_call_ || pending_calls_.find(next_call_) != pending_calls_.end());
+
+            pending_calls_[next_call_] = {response_id, deadline, std::move(complete)};
+            pending_call_count_.store(pending_calls_.size(), std::memory_order_relaxed);
+            call_deadlines_.schedule(deadline, next_call_);
 
-            if (on_disconnect_callback_)
-                on_disconnect_callback_(this);
+            call = next_call_;
         }
     }
+
+    if (call)
+    {
+        // the processing thread may be asleep until a later deadline
+        signal_deadline(deadline);
+        return call;
+    }
+
+    complete(nullptr, std::make_exception_ptr(exception(exception::reason_id::call_aborted, "async_connect_client::call: not connected")));
+    return 0;
+}
+
+void async_connect_client::complete_call(packet::call_id call, packet::packet_id id, packet::detail::serializer &s)
+{
+    pending_call pending = {};
+
+    {
+        std::lock_guard guard(calls_mtx_);
+
+        // a response that arrives after its call timed out is dropped
+        auto it = pending_calls_.find(call);
+
+        if (it == pending_calls_.end())
+            return;
+
+        pending = std::move(it->second);
+        pending_calls_.erase(it);
+        pending_call_count_.store(pending_calls_.size(), std::memory_order_relaxed);
+    }
+
+    if (id != pending.response_id)
+    {
+        pending.complete(nullptr, std::make_exception_ptr(exception(exception::reason_id::bad_response, "async_connect_client::call: response has an unexpected packet id")));
+        return;
+    }
+
+    pending.complete(&s, nullptr);
+}
+
+void async_connect_client::expire_calls()
+{
+    auto now = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard guard(calls_mtx_);
+
+        // a timer whose call already completed, or whose id was reused by a later call, finds nothing due
+        call_deadlines_.advance(now, [this, now](const packet::call_id &call)
+                                {
+            auto it = pending_calls_.find(call);
+
+            if (it == pending_calls_.end() || it->second.deadline > now)
+                return;
+
+            finished_calls_.push_back(std::move(it->second));
+            pending_calls_.erase(it); });
+
+        pending_call_count_.store(pending_calls_.size(), std::memory_order_relaxed);
+    }
+
+    for (auto &pending : finished_calls_)
+        pending.complete(nullptr, std::make_exception_ptr(exception(exception::reason_id::call_timeout, "async_connect_client::call: no response within the timeout")));
+
+    finished_calls_.clear();
+}
+
+void async_connect_client::abort_calls()
+{
+    {
+        std::lock_guard guard(calls_mtx_);
+
+        for (auto &[call, pending] : pending_calls_)
+            finished_calls_.push_back(std::move(pending));
+
+        pending_calls_.clear();
+        pending_call_count_.store(0, std::memory_order_relaxed);
+    }
+
+    for (auto &pending : finished_calls_)
+        pending.complete(nullptr, std::make_exception_ptr(exception(exception::reason_id::call_aborted, "async_connect_client::call: connection was closed")));
+
+    finished_calls_.clear();
+}
+
+bool async_connect_client::wait_for_packet(const packet_waiter &waiter)
+{
+    std::lock_guard guard(coroutines_mtx_);
+
+    // checked under the lock, the processing thread fails every registered waiter after it saw the disconnect
+    if (!connected_)
+        return false;
+
+    packet_waiters_.push_back(waiter);
+    waiter_count_++;
+
+    return true;
+}
+
+bool async_connect_client::complete_read(packet::packet_id id, packet::detail::serializer &s)
+{
+    if (!waiter_count_)
+        return false;
+
+    packet_waiter waiter = {};
+
+    {
+        std::lock_guard guard(coroutines_mtx_);
+
+        auto it = std::find_if(packet_waiters_.begin(), packet_waiters_.end(), [id](const packet_waiter &w)
+                               { return w.id == id; });
+
+        if (it == packet_waiters_.end())
+            return false;
+
+        waiter = *it;
+        packet_waiters_.erase(it);
+        waiter_count_--;
+    }
+
+    waiter.complete(waiter.awaiter, &s);
+    return true;
+}
+
+bool async_connect_client::resume_on_processing(std::coroutine_handle<> handle)
+{
+    std::lock_guard guard(coroutines_mtx_);
+
+    if (!connected_)
+        return false;
+
+    ready_coroutines_.push_back(handle);
+    signal_processing();
+
+    return true;
+}
+
+bool async_connect_client::queue_and_resume(std::vector<std::uint8_t> &&data, std::coroutine_handle<> handle)
+{
+    std::lock_guard guard(coroutines_mtx_);
+
+    if (!connected_)
+        return false;
+
+    // both happen under the lock: the coroutine is not resumed before its packet is queued, and is resumed before
+    // anything the packet is answered with gets processed
+    ready_coroutines_.push_back(handle);
+    queue_packet(std::move(data));
+    signal_processing();
+
+    return true;
+}
+
+void async_connect_client::resume_coroutines()
+{
+    {
+        std::lock_guard guard(coroutines_mtx_);
+        resuming_coroutines_.swap(ready_coroutines_);
+    }
+
+    for (auto handle : resuming_coroutines_)
+        handle.resume();
+
+    resuming_coroutines_.clear();
+}
+
+void async_connect_client::abort_coroutines()
+{
+    {
+        std::lock_guard guard(coroutines_mtx_);
+
+        failed_waiters_.swap(packet_waiters_);
+        resuming_coroutines_.swap(ready_coroutines_);
+        waiter_count_ = 0;
+    }
+
+    for (auto &waiter : failed_waiters_)
+        waiter.complete(waiter.awaiter, nullptr);
+
+    for (auto handle : resuming_coroutines_)
+        handle.resume();
+
+    failed_waiters_.clear();
+    resuming_coroutines_.clear();
+}
+
+void async_connect_client::queue_packet(std::vector<std::uint8_t> &&data)
+{
+    // compressed on the sending thread, the receiving thread only writes
+    if (compressing_ && data.size() >= sizeof(packet::header) + compression_threshold_)
+    {
+        auto compressed = net::buffer_pool::acquire(0);
+
+        if (packet::detail::compress_frame(data.data(), data.size(), compressed))
+            data.swap(compressed);
+
+        net::buffer_pool::release(std::move(compressed));
+    }
+
+    // the receiving thread owns the socket and writes the packet out, failures surface as a disconnect
+    outbound_packets_.push(std::move(data));
+
+    if (!wake_pending_.exchange(true))
+        engine_.wake();
+}
+
+void async_connect_client::flush_outbound_packets()
+{
+    wake_pending_.store(false);
+
+    outbound_packets_.consume([this](std::vector<std::uint8_t> &&packet)
+                              { engine_.write(server_token_, std::move(packet)); });
+}
+
+void async_connect_client::signal_processing()
+{
+    {
+        std::lock_guard guard(signal_mtx_);
+
+        if (signalled_)
+            return;
+
+        signalled_ = true;
+    }
+
+    signal_cv_.notify_one();
+}
+
+void async_connect_client::signal_deadline(std::chrono::steady_clock::time_point due)
+{
+    {
+        std::lock_guard guard(signal_mtx_);
+
+        // an awake processing thread reads the deadlines again before it sleeps
+        if (signalled_ || due >= processing_wakes_at_)
+            return;
+
+        signalled_ = true;
+    }
+
+    signal_cv_.notify_one();
+}
+
+void async_connect_client::wait_for_work()
+{
+    std::unique_lock guard(signal_mtx_);
+
+    // read while holding signal_mtx_, so a call registered after this still sees the deadline slept towards
+    int timeout_ms = -1;
+    auto now = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard calls_guard(calls_mtx_);
+        timeout_ms = call_deadlines_.next_timeout(now);
+    }
+
+    processing_wakes_at_ = timeout_ms < 0 ? std::chrono::steady_clock::time_point::max() : now + std::chrono::milliseconds(timeout_ms);
+
+    if (trim_pending_)
+        processing_wakes_at_ = std::min(processing_wakes_at_, trim_at_);
+
+    if (processing_wakes_at_ == std::chrono::steady_clock::time_point::max())
+        signal_cv_.wait(guard, [this]
+                        { return signalled_; });
+    else
+        signal_cv_.wait_until(guard, processing_wakes_at_, [this]
+                              { return signalled_; });
+
+    // awake, so nothing needs to signal a deadline until the next wait
+    processing_wakes_at_ = std::chrono::steady_clock::time_point::min();
+    signalled_ = false;
 }
 
 void async_connect_client::process_data()
 {
     while (true)
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        wait_for_work();
 
-        std::lock_guard guard(process_mtx_);
+        // read first: everything received before the disconnect is then already in received_
+        bool was_connected = connected_;
 
-        if (!connected_)
+        // the whole batch is taken at once, the receiving thread goes on filling received_ while it is dispatched. a
+        // large frame being received in place is left alone until it is complete
         {
-            if (process_buffer_.size() < sizeof(packet::header))
+            std::lock_guard guard(process_mtx_);
+
+            if (!receiving_in_place_ || received_.size() >= awaited_bytes_)
+            {
+                if (process_buffer_.empty())
+                    process_buffer_.swap(received_);
+                else
+                    process_buffer_.append(received_.data(), received_.size());
+
+                received_.clear();
+                receiving_in_place_ = false;
+            }
+        }
+
+        resume_coroutines();
+
+        while (process_buffer_.size() >= sizeof(packet::header))
+        {
+            packet::header header = {};
+            memcpy(&header, process_buffer_.data(), sizeof(header));
+
+            if (header.magic != PACKET_MAGIC || header.length < sizeof(packet::header) || header.length > max_frame_size_)
+            {
+                disconnect_internal(disconnect_reasons::reason_error);
+                process_buffer_.clear();
                 break;
+            }
 
-            auto header = reinterpret_cast<packet::header *>(process_buffer_.data());
+            if (process_buffer_.size() < header.length)
+                break;
 
-            if (process_buffer_.size() < header->length)
+            auto payload = std::span(process_buffer_.data() + sizeof(packet::header), header.length - sizeof(packet::header));
+
+            if (header.flags & packet::flags::fl_compressed)
+            {
+                if (!compressing_ || !packet::detail::decompress_payload(payload.data(), payload.size(), max_frame_size_ - sizeof(packet::header), inflated_))
+                {
+                    disconnect_internal(disconnect_reasons::reason_error);
+                    process_buffer_.clear();
+                    break;
+                }
+
+                payload = std::span(inflated_.data(), inflated_.size());
+            }
+
+            packet::call_id call = 0;
+
+            if (header.flags & packet::flags::fl_response)
+            {
+                if (payload.size() < sizeof(call))
+                {
+                    disconnect_internal(disconnect_reasons::reason_error);
+                    process_buffer_.clear();
+                    break;
+                }
+
+                memcpy(&call, payload.data(), sizeof(call));
+                payload = payload.subspan(sizeof(call));
+            }
+
+            process_serializer_.assign_view(payload);
+            process_serializer_.set_encoding(header.flags & packet::flags::fl_compact ? packet::enc_compact : packet::enc_fixed);
+
+            if (header.flags & packet::flags::fl_response)
+                complete_call(call, header.id, process_serializer_);
+            else if (header.id > packet::ids::num_preset_ids && !complete_read(header.id, process_serializer_) && !handlers_.dispatch(header.id, process_serializer_, this))
+            {
+                if (process_callback_)
+                    process_callback_(this, header.id, process_serializer_);
+                else
+                    unknown_packets_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            if (process_serializer_.has_failed())
+            {
+                disconnect_internal(disconnect_reasons::reason_error);
+                process_buffer_.clear();
                 break;
+            }
+
+            process_buffer_.consume(header.length);
         }
 
-        if (process_buffer_.size() < sizeof(packet::header))
-            continue;
+        expire_calls();
 
-        auto header = reinterpret_cast<packet::header *>(process_buffer_.data());
+        // buffers that grew for a burst go back towards their floor once it has passed
+        auto now = std::chrono::steady_clock::now();
+        bool trim = now >= trim_at_;
 
-        if (header->magic != PACKET_MAGIC)
+        if (trim)
         {
-            connected_ = false;
-            break;
+            process_buffer_.trim(buffer_size_);
+            trim_at_ = now + trim_interval_;
         }
 
-        if (process_buffer_.size() < header->length)
-            continue;
+        {
+            std::lock_guard guard(process_mtx_);
 
-        auto data_start = process_buffer_.data() + sizeof(packet::header);
-        std::uint32_t data_length = header->length - sizeof(packet::header);
+            if (!receiving_in_place_)
+            {
+                awaited_bytes_ = awaited_bytes();
 
-        serializer.assign_buffer(data_start, data_length);
+                if (awaited_bytes_ >= large_frame_size_ && was_connected)
+                    receive_in_place();
+                else if (received_.size() >= awaited_bytes_)
+                    signal_processing(); // bytes that arrived during the dispatch may already finish the frame at the front
 
-        if (header->id > packet::ids::num_preset_ids)
-            process_callback_(this, header->id, serializer);
+                if (trim)
+                    received_.trim(buffer_size_);
+            }
 
-        process_buffer_.erase(process_buffer_.begin(), process_buffer_.begin() + data_length + sizeof(packet::header));
+            trim_pending_ = process_buffer_.capacity() > buffer_size_ || received_.capacity() > buffer_size_;
+
+            if (reading_held_ && (receiving_in_place_ || received_.size() <= inbound_low_))
+            {
+                reading_held_ = false;
+                resume_reading_ = true;
+                engine_.wake();
+            }
+        }
+
+        // frames that arrived before the disconnect have been drained above
+        if (!was_connected)
+            break;
     }
 
     process_buffer_.clear();
+
+    abort_calls();
+    abort_coroutines();
 }
 
 void async_connect_client::receive_data()
 {
-    std::vector<std::uint8_t> buffer(buffer_size_);
-
     while (connected_)
     {
-        int bytes_received = recv(socket_, reinterpret_cast<char *>(buffer.data()), buffer_size_, NULL);
+        flush_outbound_packets();
 
-        switch (bytes_received)
-        {
-        case -1:
-            disconnect_internal(disconnect_reasons::reason_error);
-            break;
-        case 0:
-            disconnect_internal(disconnect_reasons::reason_server_stop);
-            break;
-        default:
-            std::lock_guard guard(process_mtx_);
+        if (resume_reading_.exchange(false))
+            engine_.hold_reading(server_token_, false);
 
-            process_buffer_.insert(process_buffer_.end(), buffer.begin(), buffer.begin() + bytes_received);
-        }
+        engine_.run_once(*this, -1);
+    }
+
+    flush_outbound_packets();
+
+    // still attached means the disconnect was requested locally, so let the server know before closing
+    if (engine_.is_attached(server_token_))
+    {
+        auto header = construct_packet_header(0, packet::ids::id_disconnect, packet::flags::fl_disconnect);
+        auto header_bytes = reinterpret_cast<std::uint8_t *>(&header);
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        engine_.write(server_token_, std::vector<std::uint8_t>(header_bytes, header_bytes + sizeof(header)));
+        engine_.shutdown(server_token_);
+
+        auto deadline = std::chrono::steady_clock::now() + disconnect_timeout_;
+
+        while (engine_.is_attached(server_token_) && std::chrono::steady_clock::now() < deadline)
+            engine_.run_once(*this, 100);
+    }
+
+    engine_.close();
+    socket_ = INVALID_SOCKET;
+
+    if (on_disconnect_callback_)
+        on_disconnect_callback_(this);
+}
+
+void async_connect_client::on_accept(SOCKET client)
+{
+    closesocket(client);
+}
+
+void async_connect_client::receive_in_place()
+{
+    packet::header header = {};
+    memcpy(&header, process_buffer_.data(), sizeof(header));
+
+    // the partial frame moves over to received_ along with whatever followed it, receive_space then grows it as the
+    // rest arrives
+    process_buffer_.append(received_.data(), received_.size());
+    received_.clear();
+    received_.swap(process_buffer_);
+
+    awaited_bytes_ = header.length;
+
+    if (received_.size() >= awaited_bytes_)
+    {
+        signal_processing();
+        return;
+    }
+
+    receiving_in_place_ = true;
+}
+
+void async_connect_client::on_receive(std::uint64_t, const std::uint8_t *data, std::size_t length)
+{
+    std::lock_guard guard(process_mtx_);
+
+    auto had = received_.size();
+
+    if (data == received_.tail())
+        received_.commit(length);
+    else
+        received_.append(data, length);
+
+    // the processing thread is only woken once the frame it waits for can be complete, and only once per batch
+    if (had < awaited_bytes_ && received_.size() >= awaited_bytes_)
+        signal_processing();
+
+    // a frame received in place already has its memory, holding it back would only stall it
+    if (inbound_high_ && !reading_held_ && !receiving_in_place_ && received_.size() >= inbound_high_)
+    {
+        reading_held_ = true;
+        engine_.hold_reading(server_token_, true);
+
+        // even a partial frame is taken off received_, which is what resumes reading
+        signal_processing();
     }
 }
+
+std::span<std::uint8_t> async_connect_client::receive_space(std::uint64_t)
+{
+    std::lock_guard guard(process_mtx_);
+
+    // the processing thread does not touch received_ until the frame is complete, so it is filled outside the lock
+    if (!receiving_in_place_ || received_.size() >= awaited_bytes_)
+        return {};
+
+    // room grows with what has arrived rather than with what the header announces
+    auto room = std::min(awaited_bytes_ - received_.size(), std::max(large_frame_size_, received_.size()));
+    return {received_.prepare(room), room};
+}
+
+std::size_t async_connect_client::awaited_bytes()
+{
+    if (process_buffer_.size() < sizeof(packet::header))
+        return sizeof(packet::header) - process_buffer_.size();
+
+    packet::header header = {};
+    memcpy(&header, process_buffer_.data(), sizeof(header));
+
+    // a malformed header is rejected as soon as anything else arrives
+    if (header.magic != PACKET_MAGIC || header.length <= process_buffer_.size())
+        return 1;
+
+    return header.length - process_buffer_.size();
+}
+
+void async_connect_client::on_close(std::uint64_t)
+{
+    disconnect_internal(disconnect_reasons::reason_server_stop);
+}
@@ -1,26 +1,27 @@
 #ifndef CLIENT_H
 #define CLIENT_H
 
-#pragma region windows_includes
-
-#ifdef _WIN32
-    #include <WinSock2.h>
-    #include <WS2tcpip.h>
-    #pragma comment(lib, "ws2_32.lib")
-#else
-    #error Currently only Windows is supported.
-#endif
-
 #include <functional>
 #include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
 #include <mutex>
 #include <thread>
 #include <vector>
+#include "../net/buffer_pool.hpp"
+#include "../net/io_engine.hpp"
+#include "../net/mpsc_queue.hpp"
+#include "../net/task.hpp"
+#include "../net/timer_wheel.hpp"
+#include "../packet/compression.hpp"
+#include "../packet/dispatch.hpp"
 #include "../packet/packet.hpp"
 
 namespace acc
 {
-    class async_connect_client
+    class async_connect_client : private net::io_handler
     {
     public:
         async_connect_client();
@@ -29,16 +30,269 @@ namespace acc
         void disconnect();
         bool is_connected();
         void send_packet(packet::base_packet *const packet);
+
+        template <packet::schema_packet T>
+        void send_packet(const T &packet)
+        {
+            if (!connected_)
+                return;
+
+            queue_packet(encode_frame(packet));
+        }
+
+        // the future fails with call_timeout if no response arrived in time, or call_aborted if the connection went down
+        template <packet::schema_packet Req, packet::schema_packet Resp>
+        std::future<Resp> call(const Req &request, std::chrono::milliseconds timeout)
+        {
+            auto promise = std::make_shared<std::promise<Resp>>();
+            auto future = promise->get_future();
+
+            auto call = begin_call(Resp::id, timeout, [promise](packet::detail::serializer *const s, std::exception_ptr error)
+                                   {
+                Resp response = {};
+
+                if (!error && !packet::decode(*s, response))
+                    error = std::make_exception_ptr(exception(exception::reason_id::bad_response, "async_connect_client::call: response was malformed"));
+
+                if (error)
+                    promise->set_exception(error);
+                else
+                    promise->set_value(std::move(response)); });
+
+            if (call)
+                queue_packet(encode_frame(request, packet::flags::fl_request, call));
+
+            return future;
+        }
+
+        template <packet::schema_packet Req, packet::schema_packet Resp>
+        std::future<Resp> call(const Req &request)
+        {
+            return call<Req, Resp>(request, call_timeout_);
+        }
+
+        // resumes on the processing thread once connected, or right away on a thread of its own if connecting failed
+        class connect_awaitable
+        {
+        public:
+            connect_awaitable(async_connect_client *const client, std::string_view ip, std::string_view port) : client_(client), ip_(ip), port_(port) {}
+
+            bool await_ready()
+            {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle);
+
+            bool await_resume()
+            {
+                if (error_)
+                    std::rethrow_exception(error_);
+
+                return connected_;
+            }
+
+        private:
+            async_connect_client *const client_;
+            std::string ip_ = {}, port_ = {};
+            bool connected_ = false;
+            std::exception_ptr error_ = nullptr;
+        };
+
+        // resumes on the processing thread with the next packet of id T that nobody else waited for first, or with
+        // nothing once the connection closed. packets nobody waits for go to the callback
+        template <packet::schema_packet T>
+        class read_awaitable
+        {
+        public:
+            explicit read_awaitable(async_connect_client *const client) : client_(client) {}
+
+            bool await_ready()
+            {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                handle_ = handle;
+                return client_->wait_for_packet({T::id, this, &read_awaitable::complete});
+            }
+
+            std::optional<T> await_resume()
+            {
+                return std::move(result_);
+            }
+
+        private:
+            static void complete(void *awaiter, packet::detail::serializer *const s)
+            {
+                auto self = static_cast<read_awaitable *>(awaiter);
+                T packet = {};
+
+                if (s && packet::decode(*s, packet))
+                    self->result_ = std::move(packet);
+
+                self->handle_.resume();
+            }
+
+            async_connect_client *const client_;
+            std::coroutine_handle<> handle_ = nullptr;
+            std::optional<T> result_ = std::nullopt;
+        };
+
+        // queues the packet and resumes on the processing thread, so a response awaited next cannot be missed
+        class send_awaitable
+        {
+        public:
+            send_awaitable(async_connect_client *const client, std::vector<std::uint8_t> &&frame) : client_(client), frame_(std::move(frame)) {}
+
+            bool await_ready()
+            {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                return client_->queue_and_resume(std::move(frame_), handle);
+            }
+
+            void await_resume() {}
+
+        private:
+            async_connect_client *const client_;
+            std::vector<std::uint8_t> frame_ = {};
+        };
+
+        // resumes on the processing thread with the response, and throws like the future returned by call
+        template <packet::schema_packet Req, packet::schema_packet Resp>
+        class call_awaitable
+        {
+        public:
+            call_awaitable(async_connect_client *const client, std::vector<std::uint8_t> &&frame, std::chrono::milliseconds timeout) : client_(client), frame_(std::move(frame)), timeout_(timeout) {}
+
+            bool await_ready()
+            {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                handle_ = handle;
+
+                auto call = client_->begin_call(Resp::id, timeout_, [this](packet::detail::serializer *const s, std::exception_ptr error)
+                                                {
+                    Resp response = {};
+
+                    if (!error && !packet::decode(*s, response))
+                        error = std::make_exception_ptr(exception(exception::reason_id::bad_response, "async_connect_client::async_call: response was malformed"));
+
+                    if (error)
+                        error_ = error;
+                    else
+                        result_ = std::move(response);
+
+                    // whichever of the completion and await_suspend comes second continues the coroutine
+                    if (completed_.exchange(true))
+                        handle_.resume(); });
+
+                if (call)
+                {
+                    memcpy(frame_.data() + sizeof(packet::header), &call, sizeof(call));
+                    client_->queue_packet(std::move(frame_));
+                }
+
+                return !completed_.exchange(true);
+            }
+
+            Resp await_resume()
+            {
+                if (error_)
+                    std::rethrow_exception(error_);
+
+                return std::move(*result_);
+            }
+
+        private:
+            async_connect_client *const client_;
+            std::vector<std::uint8_t> frame_ = {};
+            std::chrono::milliseconds timeout_ = {};
+            std::coroutine_handle<> handle_ = nullptr;
+            std::atomic_bool completed_ = false;
+            std::optional<Resp> result_ = std::nullopt;
+            std::exception_ptr error_ = nullptr;
+        };
+
+        connect_awaitable async_connect(std::string_view ip, std::string_view port);
+
+        template <packet::schema_packet T>
+        read_awaitable<T> async_read()
+        {
+            return read_awaitable<T>(this);
+        }
+
+        template <packet::schema_packet T>
+        send_awaitable async_send(const T &packet)
+        {
+            return send_awaitable(this, encode_frame(packet));
+        }
+
+        template <packet::schema_packet Req, packet::schema_packet Resp>
+        call_awaitable<Req, Resp> async_call(const Req &request, std::chrono::milliseconds timeout)
+        {
+            return call_awaitable<Req, Resp>(this, encode_frame(request, packet::flags::fl_request), timeout);
+        }
+
+        template <packet::schema_packet Req, packet::schema_packet Resp>
+        call_awaitable<Req, Resp> async_call(const Req &request)
+        {
+            return async_call<Req, Resp>(request, call_timeout_);
+        }
+
+        void set_max_elements(std::uint32_t max_elements);
+        void set_max_frame_size(std::uint32_t max_frame_size);
+        void set_inbound_limits(std::size_t low, std::size_t high);
+        void set_compression(bool enabled, std::uint32_t min_size);
+        void set_call_timeout(std::chrono::milliseconds timeout);
+        void set_connect_timeout(std::chrono::milliseconds timeout);
         void register_callback(std::function<void(async_connect_client *const, const packet::packet_id, packet::detail::serializer &)> callback_fn);
         void register_disconnect_callback(std::function<void(async_connect_client *const)> callback_fn);
 
+        // handler_fn is called as handler_fn(client, packet) for every packet::T received
+        template <packet::schema_packet T, typename F>
+        void register_handler(F &&handler_fn)
+        {
+            handlers_.template add<T>(std::forward<F>(handler_fn));
+        }
+
+        std::uint64_t get_unknown_packets();
+        std::size_t get_pending_calls();
+
     private:
         #ifdef _WIN32
             WSADATA wsa_data_ = {};
         #endif
         packet::header construct_packet_header(packet::packet_length length, packet::packet_id id, packet::packet_flags flags);
+
+        // a request carries its call id in front of its payload
+        template <packet::schema_packet T>
+        std::vector<std::uint8_t> encode_frame(const T &packet, packet::packet_flags flags = packet::flags::fl_none, packet::call_id call = 0)
+        {
+            std::size_t prefix = flags & packet::flags::fl_request ? sizeof(call) : 0;
+
+            auto packet_data = net::buffer_pool::acquire(sizeof(packet::header) + prefix + packet::encoded_size(packet));
+
+            auto packet_header = construct_packet_header(packet_data.size() - sizeof(packet::header), T::id, packet::encoding_flags<T>() | flags);
+            memcpy(packet_data.data(), &packet_header, sizeof(packet::header));
+            memcpy(packet_data.data() + sizeof(packet::header), &call, prefix);
+
+            packet::encode(packet, packet_data.data() + sizeof(packet::header) + prefix);
+
+            return packet_data;
+        }
+
         bool perform_handshake();
         bool send_packet_internal(void *const data, const packet::packet_length length);
+        bool receive_packet_internal(void *const data, const packet::packet_length length);
         enum class disconnect_reasons : std::uint8_t
         {
             reason_handshake_fail = 0,
@@ -48,21 +302,121 @@ namespace acc
         };
 
         void disconnect_internal(const disconnect_reasons reason);
+
+        typedef std::function<void(packet::detail::serializer *const, std::exception_ptr)> call_completion;
+
+        struct pending_call
+        {
+            packet::packet_id response_id = packet::ids::id_none;
+            std::chrono::steady_clock::time_point deadline = {};
+            call_completion complete = {};
+        };
+
+        packet::call_id begin_call(packet::packet_id response_id, std::chrono::milliseconds timeout, call_completion &&complete);
+        void complete_call(packet::call_id call, packet::packet_id id, packet::detail::serializer &s);
+        void expire_calls();
+        void abort_calls();
+
+        // a coroutine waiting for a packet, serializer is nullptr once the connection closed
+        struct packet_waiter
+        {
+            packet::packet_id id = packet::ids::id_none;
+            void *awaiter = nullptr;
+            void (*complete)(void *awaiter, packet::detail::serializer *const s) = nullptr;
+        };
+
+        bool wait_for_packet(const packet_waiter &waiter);
+        bool complete_read(packet::packet_id id, packet::detail::serializer &s);
+        bool resume_on_processing(std::coroutine_handle<> handle);
+        bool queue_and_resume(std::vector<std::uint8_t> &&data, std::coroutine_handle<> handle);
+        void resume_coroutines();
+        void abort_coroutines();
+
+        void queue_packet(std::vector<std::uint8_t> &&data);
+        void flush_outbound_packets();
+        void signal_processing();
+        void signal_deadline(std::chrono::steady_clock::time_point due);
+        void wait_for_work();
         void process_data();
         void receive_data();
+        std::size_t awaited_bytes();
+        void receive_in_place();
 
-        bool connected_ = false;
+        void on_accept(SOCKET client) override;
+        void on_receive(std::uint64_t token, const std::uint8_t *data, std::size_t length) override;
+        std::span<std::uint8_t> receive_space(std::uint64_t token) override;
+        void on_close(std::uint64_t token) override;
+
+        static constexpr std::uint64_t server_token_ = 0;
+
+        std::atomic_bool connected_ = false;
         const std::uint32_t buffer_size_ = PACKET_BUFFER_SIZE;
-        SOCKET socket_ = 0;
+        const std::chrono::seconds disconnect_timeout_ = std::chrono::seconds(5);
+        std::chrono::milliseconds connect_timeout_ = std::chrono::seconds(10);
+        SOCKET socket_ = INVALID_SOCKET;
+
+        net::io_engine engine_ = {};
+
+        // the receiving thread appends to received_ under process_mtx_, the processing thread takes it over as a whole
+        // into process_buffer_ and dispatches from there without holding the lock
+        std::mutex disconnect_mtx_ = {}, process_mtx_ = {};
+        packet::detail::frame_buffer received_ = {}, process_buffer_ = {};
+        std::size_t awaited_bytes_ = sizeof(packet::header);
+
+        // the rest of a large frame is received straight into received_, which holds its start
+        const std::size_t large_frame_size_ = 64 * 1024;
+        bool receiving_in_place_ = false;
+
+        // buffers are trimmed on the processing thread, which also wakes for it while they are above their floor
+        const std::chrono::seconds trim_interval_ = std::chrono::seconds(5);
+        std::chrono::steady_clock::time_point trim_at_ = {};
+        bool trim_pending_ = false;
+
+        // the processing thread sleeps until signalled or until its next call deadline, processing_wakes_at_ is min
+        // while it is awake
+        std::mutex signal_mtx_ = {};
+        std::condition_variable signal_cv_ = {};
+        bool signalled_ = false;
+        std::chrono::steady_clock::time_point processing_wakes_at_ = std::chrono::steady_clock::time_point::min();
+
+        // reading stops while more than the high watermark of received data waits to be processed
+        std::uint32_t max_frame_size_ = PACKET_MAX_FRAME_SIZE;
+        std::size_t inbound_low_ = 0, inbound_high_ = 0;
+        bool reading_held_ = false;
+        std::atomic_bool resume_reading_ = false;
+
+        // compression is offered in the handshake, and only used once the server has accepted it
+        bool compression_ = false;
+        std::atomic_bool compressing_ = false;
+        std::uint32_t compression_threshold_ = 0;
+        std::vector<std::uint8_t> inflated_ = {};
+
+        // calls are registered from any thread and completed on the processing thread, outside of calls_mtx_
+        std::mutex calls_mtx_ = {};
+        std::unordered_map<packet::call_id, pending_call> pending_calls_ = {};
+        net::timer_wheel<packet::call_id> call_deadlines_ = {};
+        packet::call_id next_call_ = 0;
+        std::chrono::milliseconds call_timeout_ = std::chrono::seconds(30);
+        std::vector<pending_call> finished_calls_ = {};
+        std::atomic<std::size_t> pending_call_count_ = 0;
+
+        // coroutines register from any thread and are resumed on the processing thread
+        std::mutex coroutines_mtx_ = {};
+        std::vector<packet_waiter> packet_waiters_ = {}, failed_waiters_ = {};
+        std::atomic<std::size_t> waiter_count_ = 0;
+        std::vector<std::coroutine_handle<>> ready_coroutines_ = {}, resuming_coroutines_ = {};
+        std::thread connecting_thread_ = {};
 
-        std::mutex disconnect_mtx_ = {}, process_mtx_ = {}, send_mtx_ = {};
-        std::vector<std::uint8_t> process_buffer_ = {};
+        net::mpsc_queue<std::vector<std::uint8_t>> outbound_packets_ = {};
+        std::atomic_bool wake_pending_ = false;
 
         std::function<void(async_connect_client *const)> on_disconnect_callback_ = {};
         std::function<void(async_connect_client *const, const packet::packet_id, packet::detail::serializer &)> process_callback_ = {};
+        packet::dispatch_table<async_connect_client *> handlers_ = {};
+        std::atomic<std::uint64_t> unknown_packets_ = 0;
 
         std::thread processing_thread_ = {}, receiving_thread_ = {};
-        packet::detail::serializer serializer = {};
+        packet::detail::serializer process_serializer_ = {};
 
     public:
         class exception : public std::exception
@@ -78,7 +432,12 @@ namespace acc
                 connection_error,
                 packet_nullptr,
                 null_callback,
-                no_callback
+                no_callback,
+                event_loop_failure,
+                invalid_limits,
+                call_timeout,
+                call_aborted,
+                bad_response
             };
 
             exception(reason_id reason, std::string_view what) : reason_(reason), what_(what){};
@@ -0,0 +1,318 @@
+#include "client_pool.hpp"
+
+using namespace acc;
+
+client_pool::~client_pool()
+{
+    stop();
+
+    // the clients report their disconnects to this pool, so they go before the rest of it
+    connections_.clear();
+}
+
+void client_pool::add_endpoint(std::string_view ip, std::string_view port)
+{
+    if (running_)
+        throw exception(exception::reason_id::already_running, "client_pool::add_endpoint: attempted to add an endpoint while the pool was running");
+
+    endpoints_.push_back({std::string(ip), std::string(port)});
+}
+
+void client_pool::start(std::size_t connections)
+{
+    if (running_)
+        throw exception(exception::reason_id::already_running, "client_pool::start: attempted to start the pool while it was running");
+
+    if (endpoints_.empty())
+        throw exception(exception::reason_id::no_endpoints, "client_pool::start: no endpoint to connect to");
+
+    if (!connections)
+        throw exception(exception::reason_id::invalid_count, "client_pool::start: a pool needs at least one connection");
+
+    connections_.clear();
+    connections_.resize(connections);
+
+    for (std::size_t i = 0; i < connections; i++)
+    {
+        auto &c = connections_[i];
+
+        c.client = std::make_unique<async_connect_client>();
+        c.endpoint = i % endpoints_.size();
+
+        if (on_setup_callback_)
+            on_setup_callback_(this, c.client.get());
+
+        c.client->register_disconnect_callback([this](async_connect_client *const client)
+                                               {
+            {
+                std::lock_guard guard(supervise_mtx_);
+                changed_ = true;
+            }
+
+            supervise_cv_.notify_one();
+
+            if (on_disconnect_callback_)
+                on_disconnect_callback_(this, client); });
+    }
+
+    jitter_.seed(std::random_device{}());
+    changed_ = false;
+    running_ = true;
+
+    supervising_thread_ = std::thread(&client_pool::supervise, this);
+}
+
+void client_pool::stop()
+{
+    {
+        std::lock_guard guard(supervise_mtx_);
+
+        if (!running_.exchange(false))
+            return;
+    }
+
+    supervise_cv_.notify_all();
+
+    if (supervising_thread_.joinable())
+        supervising_thread_.join();
+
+    for (auto &c : connections_)
+        c.client->disconnect();
+}
+
+bool client_pool::is_running()
+{
+    return running_;
+}
+
+std::size_t client_pool::get_connected_count()
+{
+    if (!running_)
+        return 0;
+
+    std::size_t count = 0;
+
+    for (auto &c : connections_)
+        count += c.client->is_connected();
+
+    return count;
+}
+
+async_connect_client *client_pool::next_client()
+{
+    auto count = connections_.size();
+
+    if (!running_ || !count)
+        return nullptr;
+
+    // both policies start at a rotating offset, so connections that tie on outstanding calls take turns
+    auto first = next_connection_.fetch_add(1, std::memory_order_relaxed);
+
+    if (balancing_ == balancing::round_robin)
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            auto client = connections_[(first + i) % count].client.get();
+
+            if (client->is_connected())
+                return client;
+        }
+
+        return nullptr;
+    }
+
+    async_connect_client *best = nullptr;
+    std::size_t fewest = SIZE_MAX;
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        auto client = connections_[(first + i) % count].client.get();
+
+        if (!client->is_connected())
+            continue;
+
+        auto outstanding = client->get_pending_calls();
+
+        if (outstanding < fewest)
+        {
+            best = client;
+            fewest = outstanding;
+
+            if (!fewest)
+                break;
+        }
+    }
+
+    return best;
+}
+
+bool client_pool::send_packet(packet::base_packet *const packet)
+{
+    auto client = next_client();
+
+    if (!client)
+        return false;
+
+    client->send_packet(packet);
+    return true;
+}
+
+void client_pool::set_balancing(balancing mode)
+{
+    if (running_)
+        throw exception(exception::reason_id::already_running, "client_pool::set_balancing: attempted to change balancing while the pool was running");
+
+    balancing_ = mode;
+}
+
+void client_pool::set_backoff(std::chrono::milliseconds initial, std::chrono::milliseconds max)
+{
+    if (running_)
+        throw exception(exception::reason_id::already_running, "client_pool::set_backoff: attempted to change backoff while the pool was running");
+
+    if (initial.count() < 1 || initial > max)
+        throw exception(exception::reason_id::invalid_backoff, "client_pool::set_backoff: initial backoff is zero or above the maximum");
+
+    backoff_initial_ = initial;
+    backoff_max_ = max;
+}
+
+void client_pool::set_call_timeout(std::chrono::milliseconds timeout)
+{
+    call_timeout_ = timeout;
+}
+
+void client_pool::register_setup_callback(std::function<void(client_pool *const, async_connect_client *const)> callback_fn)
+{
+    on_setup_callback_ = callback_fn;
+}
+
+void client_pool::register_connect_callback(std::function<void(client_pool *const, async_connect_client *const)> callback_fn)
+{
+    on_connect_callback_ = callback_fn;
+}
+
+void client_pool::register_disconnect_callback(std::function<void(client_pool *const, async_connect_client *const)> callback_fn)
+{
+    on_disconnect_callback_ = callback_fn;
+}
+
+void client_pool::supervise()
+{
+    while (running_)
+    {
+        auto wake_at = std::chrono::steady_clock::time_point::max();
+
+        for (auto &c : connections_)
+        {
+            if (!running_)
+                break;
+
+            // a connection with an attempt in flight belongs to its attempt thread until that reports back
+            {
+                std::lock_guard guard(supervise_mtx_);
+
+                if (c.attempting)
+                    continue;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+
+            if (c.attempt.joinable())
+            {
+                c.attempt.join();
+
+                // the next attempt goes to the next endpoint, so a server that is down does not keep its share of connections
+                if (!c.up)
+                {
+                    c.failures++;
+                    c.endpoint = (c.endpoint + 1) % endpoints_.size();
+                    c.next_attempt = now + backoff(c.failures);
+                }
+            }
+
+            if (c.client->is_connected())
+                continue;
+
+            // a connection that just dropped waits a little too, so a restarting server is not hit by every client at once
+            if (c.up)
+            {
+                c.up = false;
+                c.next_attempt = now + backoff(0);
+            }
+
+            if (c.next_attempt > now)
+            {
+                wake_at = std::min(wake_at, c.next_attempt);
+                continue;
+            }
+
+            // each attempt gets a thread of its own, so an endpoint that does not answer only stalls its own connections.
+            // the attempt only connects, what follows a failure is decided here
+            c.attempting = true;
+            c.attempt = std::thread([this, &c]
+                                    {
+                c.up = reconnect(c);
+
+                {
+                    std::lock_guard guard(supervise_mtx_);
+                    c.attempting = false;
+                    changed_ = true;
+                }
+
+                supervise_cv_.notify_one(); });
+        }
+
+        std::unique_lock guard(supervise_mtx_);
+
+        auto woken = [this]
+        { return changed_ || !running_; };
+
+        if (wake_at == std::chrono::steady_clock::time_point::max())
+            supervise_cv_.wait(guard, woken);
+        else
+            supervise_cv_.wait_until(guard, wake_at, woken);
+
+        changed_ = false;
+    }
+
+    for (auto &c : connections_)
+    {
+        if (c.attempt.joinable())
+            c.attempt.join();
+    }
+}
+
+bool client_pool::reconnect(connection &c)
+{
+    auto &target = endpoints_[c.endpoint];
+
+    try
+    {
+        if (c.client->connect(target.ip, target.port))
+        {
+            c.failures = 0;
+
+            if (on_connect_callback_)
+                on_connect_callback_(this, c.client.get());
+
+            return true;
+        }
+    }
+    catch (const async_connect_client::exception &)
+    {
+    }
+
+    return false;
+}
+
+std::chrono::milliseconds client_pool::backoff(std::uint32_t failures)
+{
+    auto delay = backoff_initial_.count() << std::min<std::uint32_t>(failures, 20);
+    delay = std::min<long long>(delay, backoff_max_.count());
+
+    // equal jitter: at least half the delay, the rest random
+    std::uniform_int_distribution<long long> spread(delay / 2, delay);
+
+    return std::chrono::milliseconds(spread(jitter_));
+}
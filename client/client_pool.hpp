@@ -0,0 +1,154 @@
+#ifndef CLIENT_POOL_H
+#define CLIENT_POOL_H
+
+#include <condition_variable>
+#include <memory>
+#include <random>
+#include <string>
+#include "client.hpp"
+
+namespace acc
+{
+    // keeps a fixed number of client connections spread over one or more servers and reconnects those that drop.
+    // sends and calls go out over a healthy connection picked round robin, or the one with the fewest calls awaiting
+    // a response
+    class client_pool
+    {
+    public:
+        enum class balancing : std::uint8_t
+        {
+            round_robin = 0,
+            least_outstanding
+        };
+
+        client_pool() = default;
+        ~client_pool();
+
+        client_pool(const client_pool &) = delete;
+        client_pool &operator=(const client_pool &) = delete;
+
+        void add_endpoint(std::string_view ip, std::string_view port);
+        void start(std::size_t connections);
+        void stop();
+        bool is_running();
+        std::size_t get_connected_count();
+
+        // nullptr if no connection is up
+        async_connect_client *next_client();
+
+        bool send_packet(packet::base_packet *const packet);
+
+        template <packet::schema_packet T>
+        bool send_packet(const T &packet)
+        {
+            auto client = next_client();
+
+            if (!client)
+                return false;
+
+            client->send_packet(packet);
+            return true;
+        }
+
+        template <packet::schema_packet Req, packet::schema_packet Resp>
+        std::future<Resp> call(const Req &request, std::chrono::milliseconds timeout)
+        {
+            auto client = next_client();
+
+            if (client)
+                return client->call<Req, Resp>(request, timeout);
+
+            std::promise<Resp> promise = {};
+            promise.set_exception(std::make_exception_ptr(async_connect_client::exception(async_connect_client::exception::reason_id::call_aborted, "client_pool::call: no connection is up")));
+
+            return promise.get_future();
+        }
+
+        template <packet::schema_packet Req, packet::schema_packet Resp>
+        std::future<Resp> call(const Req &request)
+        {
+            return call<Req, Resp>(request, call_timeout_);
+        }
+
+        void set_balancing(balancing mode);
+        void set_backoff(std::chrono::milliseconds initial, std::chrono::milliseconds max);
+        void set_call_timeout(std::chrono::milliseconds timeout);
+        void register_setup_callback(std::function<void(client_pool *const, async_connect_client *const)> callback_fn);
+        void register_connect_callback(std::function<void(client_pool *const, async_connect_client *const)> callback_fn);
+        void register_disconnect_callback(std::function<void(client_pool *const, async_connect_client *const)> callback_fn);
+
+    private:
+        struct endpoint
+        {
+            std::string ip = {}, port = {};
+        };
+
+        struct connection
+        {
+            std::unique_ptr<async_connect_client> client = {};
+            std::size_t endpoint = 0;
+            std::uint32_t failures = 0;
+            bool up = false;
+            std::chrono::steady_clock::time_point next_attempt = {};
+
+            // attempting is guarded by supervise_mtx_
+            std::thread attempt = {};
+            bool attempting = false;
+        };
+
+        void supervise();
+        bool reconnect(connection &c);
+        std::chrono::milliseconds backoff(std::uint32_t failures);
+
+        std::vector<endpoint> endpoints_ = {};
+        std::vector<connection> connections_ = {};
+        std::atomic<std::size_t> next_connection_ = 0;
+
+        balancing balancing_ = balancing::round_robin;
+        std::chrono::milliseconds backoff_initial_ = std::chrono::milliseconds(100), backoff_max_ = std::chrono::seconds(10);
+        std::chrono::milliseconds call_timeout_ = std::chrono::seconds(30);
+        std::minstd_rand jitter_ = {};
+
+        // disconnects and finished attempts are reported from their own threads and handled on the supervising thread
+        std::atomic_bool running_ = false;
+        std::mutex supervise_mtx_ = {};
+        std::condition_variable supervise_cv_ = {};
+        bool changed_ = false;
+        std::thread supervising_thread_ = {};
+
+        std::function<void(client_pool *const, async_connect_client *const)> on_setup_callback_ = {};
+        std::function<void(client_pool *const, async_connect_client *const)> on_connect_callback_ = {}, on_disconnect_callback_ = {};
+
+    public:
+        class exception : public std::exception
+        {
+        public:
+            enum reason_id : std::uint8_t
+            {
+                none = 0,
+                already_running,
+                no_endpoints,
+                invalid_count,
+                invalid_backoff
+            };
+
+            exception(reason_id reason, std::string_view what) : reason_(reason), what_(what){};
+
+            virtual const char *what() const noexcept
+            {
+                return what_.data();
+            }
+
+            const reason_id get_reason()
+            {
+                return reason_;
+            }
+
+        private:
+            std::string what_ = {};
+            reason_id reason_ = reason_id::none;
+        };
+    };
+}
+
+#endif
@@ -1,13 +1,8 @@
 #include "client.hpp"
 #include <iostream>
 
-#define PACKET_PROCESS(ID, name) void name(acc::async_connect_client *const cl, const acc::packet::packet_id id, acc::packet::detail::serializer &s)
-
-PACKET_PROCESS(acc::packet::id_example, on_example_packet)
+void on_example_packet(acc::async_connect_client *const cl, acc::packet::example_packet &example)
 {
-    // read packet
-    acc::packet::example_packet example(s);
-
     // access the data
     for (std::size_t i = 0; i < example.some_string_array.size(); i++)
         printf("[ %i ] %s\n", i, example.some_string_array[i].data());
@@ -25,15 +20,8 @@ int main()
         client.register_disconnect_callback([](acc::async_connect_client *const cl)
                                             { printf("Disconnected from server.\n"); });
 
-        client.register_callback([](acc::async_connect_client *const cl, const acc::packet::packet_id id, acc::packet::detail::serializer &s)
-                                 {
-			switch ( id ) {
-				case acc::packet::id_example:
-					on_example_packet( cl, id, s );
-					break;
-				default:
-					printf( "Unknown packet ID %i received\n", id );
-			} });
+        // packets arrive decoded, those without a handler are counted by get_unknown_packets()
+        client.register_handler<acc::packet::example_packet>(on_example_packet);
 
         if (client.connect("localhost", "1337"))
         {
@@ -46,8 +34,23 @@ int main()
             example.some_array = {1, 2, 3, 4, 5};
             example.some_string_array = {"Hello", "from", "client!"};
 
+            // call the server and wait for its reply, any number of calls may be in flight at once
+            auto reply = client.call<acc::packet::example_packet, acc::packet::example_packet>(example, std::chrono::seconds(5));
+
+            try
+            {
+                auto response = reply.get();
+
+                for (std::size_t i = 0; i < response.some_string_array.size(); i++)
+                    printf("[ %i ] %s\n", i, response.some_string_array[i].data());
+            }
+            catch (const acc::async_connect_client::exception &e)
+            {
+                printf("%s\n", e.what());
+            }
+
             // send packet
-            client.send_packet(&example);
+            client.send_packet(example);
 
             // wait for server response
             while (client.is_connected())
@@ -0,0 +1,74 @@
+#include "buffer_pool.hpp"
+
+using namespace acc::net;
+
+std::mutex buffer_pool::depot_mtx_ = {};
+buffer_pool::buffer_list buffer_pool::depot_ = {};
+
+std::vector<std::uint8_t> buffer_pool::acquire(std::size_t size)
+{
+    auto &buffers = local_buffers();
+
+    if (buffers.empty())
+    {
+        std::lock_guard guard(depot_mtx_);
+
+        while (!depot_.empty() && buffers.size() < batch_size_)
+        {
+            buffers.push_back(std::move(depot_.back()));
+            depot_.pop_back();
+        }
+    }
+
+    if (buffers.empty())
+        return std::vector<std::uint8_t>(size);
+
+    auto buffer = std::move(buffers.back());
+    buffers.pop_back();
+
+    buffer.resize(size);
+    return buffer;
+}
+
+void buffer_pool::release(std::vector<std::uint8_t> &&buffer)
+{
+    // oversized buffers would pin memory long after the burst that needed them
+    if (buffer.capacity() == 0 || buffer.capacity() > max_buffer_capacity_)
+        return;
+
+    auto &buffers = local_buffers();
+
+    buffer.clear();
+    buffers.push_back(std::move(buffer));
+
+    if (buffers.size() < batch_size_ * 2)
+        return;
+
+    // hand a batch to the depot, the lists themselves never grow past their reserved size so moving buffers around
+    // does not allocate either
+    std::lock_guard guard(depot_mtx_);
+
+    if (depot_.capacity() == 0)
+        depot_.reserve(max_depot_buffers_);
+
+    while (buffers.size() > batch_size_)
+    {
+        if (depot_.size() < max_depot_buffers_)
+            depot_.push_back(std::move(buffers.back()));
+
+        buffers.pop_back();
+    }
+}
+
+buffer_pool::buffer_list &buffer_pool::local_buffers()
+{
+    thread_local buffer_list buffers = []
+    {
+        buffer_list list = {};
+        list.reserve(batch_size_ * 2);
+
+        return list;
+    }();
+
+    return buffers;
+}
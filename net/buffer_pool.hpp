@@ -0,0 +1,33 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace acc::net
+{
+    // recycles packet buffers so steady state sending does not allocate. every thread keeps its own free list, and
+    // batches move through a shared depot so buffers acquired on one thread and released on another (a send posted
+    // to an io thread) still find their way back
+    class buffer_pool
+    {
+    public:
+        static std::vector<std::uint8_t> acquire(std::size_t size);
+        static void release(std::vector<std::uint8_t> &&buffer);
+
+    private:
+        typedef std::vector<std::vector<std::uint8_t>> buffer_list;
+
+        static constexpr std::size_t batch_size_ = 32;
+        static constexpr std::size_t max_depot_buffers_ = 4096;
+        static constexpr std::size_t max_buffer_capacity_ = 1024 * 1024;
+
+        static buffer_list &local_buffers();
+
+        static std::mutex depot_mtx_;
+        static buffer_list depot_;
+    };
+}
+
+#endif
@@ -0,0 +1,291 @@
+#include "event_loop.hpp"
+
+using namespace acc::net;
+
+#ifdef _WIN32
+
+event_loop::~event_loop()
+{
+    close();
+}
+
+bool event_loop::open()
+{
+    wake_socket_ = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (wake_socket_ == INVALID_SOCKET)
+        return false;
+
+    wake_address_.sin_family = AF_INET;
+    wake_address_.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    wake_address_.sin_port = 0;
+
+    int address_length = sizeof(wake_address_);
+
+    if (bind(wake_socket_, reinterpret_cast<sockaddr *>(&wake_address_), address_length) == SOCKET_ERROR ||
+        getsockname(wake_socket_, reinterpret_cast<sockaddr *>(&wake_address_), &address_length) == SOCKET_ERROR ||
+        !set_non_blocking(wake_socket_))
+    {
+        close();
+        return false;
+    }
+
+    return add(wake_socket_, wake_token, event_flags::ev_read);
+}
+
+void event_loop::close()
+{
+    std::lock_guard guard(registration_mtx_);
+
+    if (wake_socket_ != INVALID_SOCKET)
+    {
+        closesocket(wake_socket_);
+        wake_socket_ = INVALID_SOCKET;
+    }
+
+    poll_fds_.clear();
+    tokens_.clear();
+    indices_.clear();
+}
+
+bool event_loop::add(SOCKET s, std::uint64_t token, std::uint32_t events)
+{
+    std::lock_guard guard(registration_mtx_);
+
+    if (indices_.find(s) != indices_.end())
+        return false;
+
+    WSAPOLLFD fd = {};
+    fd.fd = s;
+    fd.events = (events & event_flags::ev_read ? POLLRDNORM : 0) | (events & event_flags::ev_write ? POLLWRNORM : 0);
+
+    indices_[s] = poll_fds_.size();
+    poll_fds_.push_back(fd);
+    tokens_.push_back(token);
+
+    return true;
+}
+
+bool event_loop::modify(SOCKET s, std::uint64_t token, std::uint32_t events)
+{
+    std::lock_guard guard(registration_mtx_);
+
+    auto it = indices_.find(s);
+
+    if (it == indices_.end())
+        return false;
+
+    poll_fds_[it->second].events = (events & event_flags::ev_read ? POLLRDNORM : 0) | (events & event_flags::ev_write ? POLLWRNORM : 0);
+    tokens_[it->second] = token;
+
+    return true;
+}
+
+void event_loop::remove(SOCKET s)
+{
+    std::lock_guard guard(registration_mtx_);
+
+    auto it = indices_.find(s);
+
+    if (it == indices_.end())
+        return;
+
+    auto index = it->second;
+    indices_.erase(it);
+
+    if (index != poll_fds_.size() - 1)
+    {
+        poll_fds_[index] = poll_fds_.back();
+        tokens_[index] = tokens_.back();
+        indices_[poll_fds_[index].fd] = index;
+    }
+
+    poll_fds_.pop_back();
+    tokens_.pop_back();
+}
+
+std::size_t event_loop::wait(std::vector<io_event> &out_events, int timeout_ms)
+{
+    out_events.clear();
+
+    {
+        std::lock_guard guard(registration_mtx_);
+        polled_fds_ = poll_fds_;
+        polled_tokens_ = tokens_;
+    }
+
+    int ready = WSAPoll(polled_fds_.data(), static_cast<ULONG>(polled_fds_.size()), timeout_ms);
+
+    if (ready <= 0)
+        return 0;
+
+    for (std::size_t i = 0; i < polled_fds_.size(); i++)
+    {
+        auto revents = polled_fds_[i].revents;
+
+        if (!revents)
+            continue;
+
+        if (polled_tokens_[i] == wake_token)
+        {
+            char drain[64];
+            while (recv(wake_socket_, drain, sizeof(drain), 0) > 0)
+                ;
+            continue;
+        }
+
+        io_event event = {};
+        event.token = polled_tokens_[i];
+
+        if (revents & POLLRDNORM)
+            event.events |= event_flags::ev_read;
+
+        if (revents & POLLWRNORM)
+            event.events |= event_flags::ev_write;
+
+        if (revents & (POLLERR | POLLHUP | POLLNVAL))
+            event.events |= event_flags::ev_closed;
+
+        out_events.push_back(event);
+    }
+
+    return out_events.size();
+}
+
+void event_loop::wake()
+{
+    char signal = 0;
+    sendto(wake_socket_, &signal, sizeof(signal), 0, reinterpret_cast<sockaddr *>(&wake_address_), sizeof(wake_address_));
+}
+
+#else
+
+namespace
+{
+    std::uint32_t to_epoll_events(std::uint32_t events)
+    {
+        std::uint32_t result = EPOLLET | EPOLLRDHUP;
+
+        if (events & event_flags::ev_read)
+            result |= EPOLLIN;
+
+        if (events & event_flags::ev_write)
+            result |= EPOLLOUT;
+
+        return result;
+    }
+}
+
+event_loop::~event_loop()
+{
+    close();
+}
+
+bool event_loop::open()
+{
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+
+    if (epoll_fd_ == -1)
+        return false;
+
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (wake_fd_ == -1)
+    {
+        close();
+        return false;
+    }
+
+    epoll_events_.resize(256);
+
+    return add(wake_fd_, wake_token, event_flags::ev_read);
+}
+
+void event_loop::close()
+{
+    if (wake_fd_ != -1)
+    {
+        ::close(wake_fd_);
+        wake_fd_ = -1;
+    }
+
+    if (epoll_fd_ != -1)
+    {
+        ::close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+}
+
+bool event_loop::add(SOCKET s, std::uint64_t token, std::uint32_t events)
+{
+    epoll_event event = {};
+    event.events = to_epoll_events(events);
+    event.data.u64 = token;
+
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, s, &event) == 0;
+}
+
+bool event_loop::modify(SOCKET s, std::uint64_t token, std::uint32_t events)
+{
+    epoll_event event = {};
+    event.events = to_epoll_events(events);
+    event.data.u64 = token;
+
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, s, &event) == 0;
+}
+
+void event_loop::remove(SOCKET s)
+{
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, s, nullptr);
+}
+
+std::size_t event_loop::wait(std::vector<io_event> &out_events, int timeout_ms)
+{
+    out_events.clear();
+
+    int ready = epoll_wait(epoll_fd_, epoll_events_.data(), static_cast<int>(epoll_events_.size()), timeout_ms);
+
+    if (ready <= 0)
+        return 0;
+
+    for (int i = 0; i < ready; i++)
+    {
+        auto &epoll_event = epoll_events_[i];
+
+        if (epoll_event.data.u64 == wake_token)
+        {
+            std::uint64_t drain = 0;
+            while (read(wake_fd_, &drain, sizeof(drain)) > 0)
+                ;
+            continue;
+        }
+
+        io_event event = {};
+        event.token = epoll_event.data.u64;
+
+        if (epoll_event.events & EPOLLIN)
+            event.events |= event_flags::ev_read;
+
+        if (epoll_event.events & EPOLLOUT)
+            event.events |= event_flags::ev_write;
+
+        if (epoll_event.events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP))
+            event.events |= event_flags::ev_closed;
+
+        out_events.push_back(event);
+    }
+
+    // a full batch means more sockets are probably ready, so take more next time
+    if (static_cast<std::size_t>(ready) == epoll_events_.size())
+        epoll_events_.resize(epoll_events_.size() * 2);
+
+    return out_events.size();
+}
+
+void event_loop::wake()
+{
+    std::uint64_t signal = 1;
+    [[maybe_unused]] auto written = write(wake_fd_, &signal, sizeof(signal));
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <cstdint>
+#include <vector>
+#include "platform.hpp"
+
+#ifdef _WIN32
+    #include <mutex>
+    #include <unordered_map>
+#else
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+#endif
+
+namespace acc::net
+{
+    enum event_flags : std::uint32_t
+    {
+        ev_none = 0,
+        ev_read = (1 << 0),
+        ev_write = (1 << 1),
+        ev_closed = (1 << 2)
+    };
+
+    struct io_event
+    {
+        std::uint64_t token = 0;
+        std::uint32_t events = event_flags::ev_none;
+    };
+
+    // readiness is reported edge-triggered, so owners have to drain a socket until it would block
+    class event_loop
+    {
+    public:
+        static constexpr std::uint64_t wake_token = ~0ull;
+
+        event_loop() = default;
+        ~event_loop();
+
+        event_loop(const event_loop &) = delete;
+        event_loop &operator=(const event_loop &) = delete;
+
+        bool open();
+        void close();
+
+        bool add(SOCKET s, std::uint64_t token, std::uint32_t events);
+        bool modify(SOCKET s, std::uint64_t token, std::uint32_t events);
+        void remove(SOCKET s);
+
+        std::size_t wait(std::vector<io_event> &out_events, int timeout_ms);
+        void wake();
+
+    private:
+#ifdef _WIN32
+        std::mutex registration_mtx_ = {};
+        std::vector<WSAPOLLFD> poll_fds_ = {}, polled_fds_ = {};
+        std::vector<std::uint64_t> tokens_ = {}, polled_tokens_ = {};
+        std::unordered_map<SOCKET, std::size_t> indices_ = {};
+
+        SOCKET wake_socket_ = INVALID_SOCKET;
+        sockaddr_in wake_address_ = {};
+#else
+        int epoll_fd_ = -1, wake_fd_ = -1;
+
+        std::vector<epoll_event> epoll_events_ = {};
+#endif
+    };
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef IO_ENGINE_H
+#define IO_ENGINE_H
+
+#include "io_handler.hpp"
+
+// define ACC_USE_IO_URING (Linux 6.0 or newer) to drive sockets through io_uring instead of epoll/WSAPoll
+#ifdef ACC_USE_IO_URING
+    #ifndef __linux__
+        #error io_uring is only available on Linux.
+    #endif
+
+    #include "uring_engine.hpp"
+
+namespace acc::net
+{
+    typedef uring_engine io_engine;
+}
+#else
+    #include "poll_engine.hpp"
+
+namespace acc::net
+{
+    typedef poll_engine io_engine;
+}
+#endif
+
+#endif
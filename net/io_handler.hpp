@@ -0,0 +1,33 @@
+#ifndef IO_HANDLER_H
+#define IO_HANDLER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include "platform.hpp"
+
+namespace acc::net
+{
+    // completions reported by an io engine; every call happens on the thread running the engine
+    class io_handler
+    {
+    public:
+        virtual ~io_handler() = default;
+
+        virtual void on_accept(SOCKET client) = 0;
+        virtual void on_receive(std::uint64_t token, const std::uint8_t *data, std::size_t length) = 0;
+        virtual void on_close(std::uint64_t token) = 0;
+
+        // memory the stream's next bytes may be received into instead of the engine's own buffer, on_receive is then
+        // called with a pointer into it. lets a large frame land where it will be parsed without being copied there
+        virtual std::span<std::uint8_t> receive_space(std::uint64_t)
+        {
+            return {};
+        }
+
+        // a stream's unsent data crossed its high watermark (reading from it is paused) or drained back to the low one
+        virtual void on_congestion(std::uint64_t, bool) {}
+    };
+}
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace acc::net
+{
+    // hands values from any number of threads to a single consumer. pushes claim a slot of a bounded ring with one
+    // compare and swap and never allocate; only once the ring is full do they fall back to a mutex protected overflow
+    // list, and they keep using it until the consumer has taken it over so values from one thread stay in order. the
+    // consumer only takes the list over once every slot claimed in the ring has been popped
+    template <typename T, std::size_t Capacity = 1024>
+    class mpsc_queue
+    {
+        static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+    public:
+        mpsc_queue()
+        {
+            for (std::size_t i = 0; i < Capacity; i++)
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        mpsc_queue(const mpsc_queue &) = delete;
+        mpsc_queue &operator=(const mpsc_queue &) = delete;
+
+        void push(T &&value)
+        {
+            if (!overflowing_.load(std::memory_order_acquire) && try_push(value))
+                return;
+
+            std::lock_guard guard(overflow_mtx_);
+
+            overflow_.push_back(std::move(value));
+            overflowing_.store(true, std::memory_order_release);
+        }
+
+        // consumer only
+        template <typename F>
+        void consume(F &&fn)
+        {
+            T value = {};
+
+            while (try_pop(value))
+                fn(std::move(value));
+
+            // a slot claimed before the ring filled up may still be being written, the list is only taken over once
+            // it has been popped since its producer may have overflowed after it
+            if (!overflowing_.load(std::memory_order_acquire) || dequeue_position_ != enqueue_position_.load(std::memory_order_acquire))
+                return;
+
+            {
+                std::lock_guard guard(overflow_mtx_);
+
+                draining_.swap(overflow_);
+                overflowing_.store(false, std::memory_order_release);
+            }
+
+            for (auto &overflowed : draining_)
+                fn(std::move(overflowed));
+
+            draining_.clear();
+        }
+
+    private:
+        struct cell
+        {
+            std::atomic<std::size_t> sequence = 0;
+            T value = {};
+        };
+
+        bool try_push(T &value)
+        {
+            auto position = enqueue_position_.load(std::memory_order_relaxed);
+
+            while (true)
+            {
+                auto &c = cells_[position & (Capacity - 1)];
+                auto sequence = c.sequence.load(std::memory_order_acquire);
+                auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+                if (difference == 0)
+                {
+                    if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        c.value = std::move(value);
+                        c.sequence.store(position + 1, std::memory_order_release);
+
+                        return true;
+                    }
+                }
+                else if (difference < 0)
+                    return false;
+                else
+                    position = enqueue_position_.load(std::memory_order_relaxed);
+            }
+        }
+
+        bool try_pop(T &value)
+        {
+            auto &c = cells_[dequeue_position_ & (Capacity - 1)];
+
+            // a producer that claimed the slot but has not filled it yet is picked up on the next pass
+            if (c.sequence.load(std::memory_order_acquire) != dequeue_position_ + 1)
+                return false;
+
+            value = std::move(c.value);
+            c.sequence.store(dequeue_position_ + Capacity, std::memory_order_release);
+            dequeue_position_++;
+
+            return true;
+        }
+
+        std::array<cell, Capacity> cells_ = {};
+
+        alignas(64) std::atomic<std::size_t> enqueue_position_ = 0;
+        alignas(64) std::size_t dequeue_position_ = 0;
+
+        std::atomic_bool overflowing_ = false;
+        std::mutex overflow_mtx_ = {};
+        std::vector<T> overflow_ = {}, draining_ = {};
+    };
+}
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef OUTBOUND_QUEUE_H
+#define OUTBOUND_QUEUE_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "platform.hpp"
+#include "buffer_pool.hpp"
+
+namespace acc::net
+{
+    // an immutable frame queued to many streams at once, it is freed once the last of them has sent it
+    typedef std::shared_ptr<const std::vector<std::uint8_t>> shared_frame;
+
+    // bounds on unsent bytes. reading from a stream pauses above high and resumes at low, a stream above max is
+    // dropped, and every stream of an engine pauses while all of them together hold more than total. 0 disables a bound
+    struct write_limits
+    {
+        std::size_t low = 0, high = 0, max = 0, total = 0;
+    };
+
+    // fifo of buffers waiting to be sent. unlike std::deque, which frees and reallocates a block every few entries
+    // while a short queue cycles through it, the storage is kept across drains so steady state queueing does not allocate
+    class outbound_queue
+    {
+    public:
+        bool empty() const
+        {
+            return head_ == buffers_.size();
+        }
+
+        // bytes still to be sent
+        std::size_t pending() const
+        {
+            return pending_;
+        }
+
+        // bytes sent over the queue's lifetime
+        std::uint64_t sent() const
+        {
+            return sent_;
+        }
+
+        // bytes queued over the queue's lifetime
+        std::uint64_t queued() const
+        {
+            return sent_ + pending_;
+        }
+
+        void push_back(std::vector<std::uint8_t> &&buffer)
+        {
+            pending_ += buffer.size();
+            buffers_.push_back({std::move(buffer), nullptr});
+        }
+
+        void push_back(const shared_frame &frame)
+        {
+            pending_ += frame->size();
+            buffers_.push_back({{}, frame});
+        }
+
+        // describes up to max_slices of the queued buffers, starting at the first unsent byte
+        std::size_t gather(io_slice *slices, std::size_t max_slices)
+        {
+            std::size_t count = 0;
+
+            for (auto i = head_; i < buffers_.size() && count < max_slices; i++, count++)
+            {
+                auto offset = i == head_ ? offset_ : 0;
+                set_slice(slices[count], buffers_[i].data() + offset, buffers_[i].size() - offset);
+            }
+
+            return count;
+        }
+
+        // marks bytes as sent, fully sent buffers go back to the pool
+        void advance(std::size_t bytes)
+        {
+            pending_ -= bytes;
+            sent_ += bytes;
+
+            while (bytes)
+            {
+                auto remaining = buffers_[head_].size() - offset_;
+
+                if (bytes < remaining)
+                {
+                    offset_ += bytes;
+                    return;
+                }
+
+                bytes -= remaining;
+                pop_front();
+            }
+        }
+
+    private:
+        struct entry
+        {
+            std::vector<std::uint8_t> owned = {};
+            shared_frame shared = nullptr;
+
+            const std::uint8_t *data() const
+            {
+                return shared ? shared->data() : owned.data();
+            }
+
+            std::size_t size() const
+            {
+                return shared ? shared->size() : owned.size();
+            }
+        };
+
+        void pop_front()
+        {
+            auto &sent = buffers_[head_++];
+
+            if (sent.shared)
+                sent.shared.reset();
+            else
+                buffer_pool::release(std::move(sent.owned));
+
+            offset_ = 0;
+
+            if (head_ == buffers_.size())
+            {
+                buffers_.clear();
+                head_ = 0;
+            }
+            else if (head_ > buffers_.size() / 2)
+            {
+                buffers_.erase(buffers_.begin(), buffers_.begin() + head_);
+                head_ = 0;
+            }
+        }
+
+        std::vector<entry> buffers_ = {};
+        std::size_t head_ = 0, offset_ = 0, pending_ = 0;
+        std::uint64_t sent_ = 0;
+    };
+}
+
+#endif
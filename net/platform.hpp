@@ -0,0 +1,168 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#pragma region platform_includes
+
+#ifdef _WIN32
+    #include <WinSock2.h>
+    #include <WS2tcpip.h>
+    #pragma comment(lib, "ws2_32.lib")
+
+    #define MSG_NOSIGNAL 0
+#elif defined(__linux__)
+    #include <sys/types.h>
+    #include <sys/socket.h>
+    #include <sys/uio.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <netdb.h>
+    #include <poll.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+
+    typedef int SOCKET;
+
+    #define INVALID_SOCKET (-1)
+    #define SOCKET_ERROR (-1)
+    #define SD_SEND SHUT_WR
+    #define SD_BOTH SHUT_RDWR
+
+    inline int closesocket(SOCKET s)
+    {
+        return ::close(s);
+    }
+#else
+    #error Currently only Windows and Linux are supported.
+#endif
+
+#pragma endregion
+
+#include <cstdint>
+#include <cstddef>
+
+namespace acc::net
+{
+#ifdef _WIN32
+    typedef WSABUF io_slice;
+#else
+    typedef iovec io_slice;
+#endif
+
+    inline void set_slice(io_slice &slice, const std::uint8_t *data, std::size_t length)
+    {
+#ifdef _WIN32
+        slice.buf = reinterpret_cast<char *>(const_cast<std::uint8_t *>(data));
+        slice.len = static_cast<ULONG>(length);
+#else
+        slice.iov_base = const_cast<std::uint8_t *>(data);
+        slice.iov_len = length;
+#endif
+    }
+
+    // gathers every slice into a single send, returns the number of bytes written or SOCKET_ERROR
+    inline long long send_slices(SOCKET s, io_slice *slices, std::size_t count)
+    {
+#ifdef _WIN32
+        DWORD sent = 0;
+
+        if (WSASend(s, slices, static_cast<DWORD>(count), &sent, 0, nullptr, nullptr) != 0)
+            return SOCKET_ERROR;
+
+        return sent;
+#else
+        msghdr message = {};
+        message.msg_iov = slices;
+        message.msg_iovlen = count;
+
+        return sendmsg(s, &message, MSG_NOSIGNAL);
+#endif
+    }
+
+    inline bool set_non_blocking(SOCKET s, bool enabled = true)
+    {
+#ifdef _WIN32
+        u_long mode = enabled ? 1 : 0;
+        return ioctlsocket(s, FIONBIO, &mode) == 0;
+#else
+        int flags = fcntl(s, F_GETFL, 0);
+        return flags != -1 && fcntl(s, F_SETFL, enabled ? flags | O_NONBLOCK : flags & ~O_NONBLOCK) == 0;
+#endif
+    }
+
+    // bounds every blocking send and receive on the socket, 0 removes the bound
+    inline bool set_io_timeout(SOCKET s, int timeout_ms)
+    {
+#ifdef _WIN32
+        DWORD timeout = static_cast<DWORD>(timeout_ms);
+#else
+        timeval timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+#endif
+        return setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<char *>(&timeout), sizeof(timeout)) == 0 &&
+               setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<char *>(&timeout), sizeof(timeout)) == 0;
+    }
+
+    inline bool last_error_would_block()
+    {
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+    }
+
+    inline bool last_error_interrupted()
+    {
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEINTR;
+#else
+        return errno == EINTR;
+#endif
+    }
+
+    // blocks until the socket can take more data or the timeout expires
+    inline bool wait_writable(SOCKET s, int timeout_ms)
+    {
+#ifdef _WIN32
+        WSAPOLLFD fd = {s, POLLWRNORM, 0};
+        return WSAPoll(&fd, 1, timeout_ms) > 0 && !(fd.revents & (POLLERR | POLLHUP | POLLNVAL));
+#else
+        pollfd fd = {s, POLLOUT, 0};
+        int result = 0;
+
+        do
+            result = ::poll(&fd, 1, timeout_ms);
+        while (result < 0 && errno == EINTR);
+
+        return result > 0 && !(fd.revents & (POLLERR | POLLHUP | POLLNVAL));
+#endif
+    }
+
+    // connects a blocking socket, giving up after timeout_ms (-1 waits as long as the system does)
+    inline bool connect_within(SOCKET s, const sockaddr *address, int length, int timeout_ms)
+    {
+        if (!set_non_blocking(s))
+            return false;
+
+        if (::connect(s, address, length) == SOCKET_ERROR)
+        {
+#ifdef _WIN32
+            if (WSAGetLastError() != WSAEWOULDBLOCK)
+                return false;
+#else
+            if (errno != EINPROGRESS)
+                return false;
+#endif
+
+            int error = 0;
+            socklen_t error_length = sizeof(error);
+
+            if (!wait_writable(s, timeout_ms) || getsockopt(s, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&error), &error_length) != 0 || error)
+                return false;
+        }
+
+        return set_non_blocking(s, false);
+    }
+}
+
+#endif
@@ -0,0 +1,544 @@
+#include "poll_engine.hpp"
+
+using namespace acc::net;
+
+poll_engine::~poll_engine()
+{
+    close();
+}
+
+bool poll_engine::open()
+{
+    receive_buffer_.resize(min_buffer_size_);
+    small_reads_ = 0;
+
+    return loop_.open();
+}
+
+void poll_engine::close()
+{
+    // give whatever is still queued one last chance to go out
+    for (auto &[token, s] : streams_)
+    {
+        if (!s.outbound.empty())
+            s.closing = true;
+    }
+
+    while (!pending_.empty())
+    {
+        auto token = pending_.back();
+        pending_.pop_back();
+
+        flush(token);
+    }
+
+    while (!streams_.empty())
+        release(streams_.begin()->first);
+
+    if (listener_ != INVALID_SOCKET)
+    {
+        loop_.remove(listener_);
+        listener_ = INVALID_SOCKET;
+    }
+
+    failed_.clear();
+    readable_.clear();
+    congestion_.clear();
+    loop_.close();
+}
+
+bool poll_engine::listen(SOCKET listener)
+{
+    if (!set_non_blocking(listener) || !loop_.add(listener, listener_token, event_flags::ev_read))
+        return false;
+
+    listener_ = listener;
+    return true;
+}
+
+bool poll_engine::attach(SOCKET s, std::uint64_t token)
+{
+    if (streams_.find(token) != streams_.end() || !set_non_blocking(s))
+        return false;
+
+    if (!loop_.add(s, token, event_flags::ev_read))
+        return false;
+
+    streams_[token].socket = s;
+    return true;
+}
+
+bool poll_engine::write(std::uint64_t token, std::vector<std::uint8_t> &&data)
+{
+    auto s = writable_stream(token);
+
+    if (!s)
+        return false;
+
+    if (data.empty())
+        return true;
+
+    total_pending_ += data.size();
+    s->outbound.push_back(std::move(data));
+
+    if (!apply_limits(token, *s))
+        return false;
+
+    mark_pending(token, *s);
+
+    return true;
+}
+
+bool poll_engine::write(std::uint64_t token, const shared_frame &frame)
+{
+    auto s = writable_stream(token);
+
+    if (!s)
+        return false;
+
+    if (frame->empty())
+        return true;
+
+    total_pending_ += frame->size();
+    s->outbound.push_back(frame);
+
+    if (!apply_limits(token, *s))
+        return false;
+
+    mark_pending(token, *s);
+
+    return true;
+}
+
+void poll_engine::shutdown(std::uint64_t token)
+{
+    auto it = streams_.find(token);
+
+    if (it == streams_.end())
+        return;
+
+    it->second.closing = true;
+
+    if (it->second.outbound.empty())
+        release(token);
+    else
+        mark_pending(token, it->second);
+}
+
+void poll_engine::hold_reading(std::uint64_t token, bool held)
+{
+    auto it = streams_.find(token);
+
+    if (it == streams_.end() || it->second.read_held == held)
+        return;
+
+    it->second.read_held = held;
+    update_interest(token, it->second);
+}
+
+void poll_engine::abort(std::uint64_t token)
+{
+    if (streams_.find(token) != streams_.end())
+        release(token);
+}
+
+bool poll_engine::is_attached(std::uint64_t token)
+{
+    return streams_.find(token) != streams_.end();
+}
+
+bool poll_engine::get_progress(std::uint64_t token, std::uint64_t &queued, std::uint64_t &sent)
+{
+    auto it = streams_.find(token);
+
+    if (it == streams_.end())
+        return false;
+
+    queued = it->second.outbound.queued();
+    sent = it->second.outbound.sent();
+
+    return true;
+}
+
+void poll_engine::run_once(io_handler &handler, int timeout_ms)
+{
+    auto flush_timeout = flush_pending();
+
+    if (flush_timeout >= 0 && (timeout_ms < 0 || flush_timeout < timeout_ms))
+        timeout_ms = flush_timeout;
+
+    report_failures(handler);
+
+    loop_.wait(events_, failed_.empty() && readable_.empty() ? timeout_ms : 0);
+
+    // streams cut off by the read cap on the last pass, edge triggered readiness does not report them again
+    still_readable_.swap(readable_);
+
+    for (auto token : still_readable_)
+    {
+        auto it = streams_.find(token);
+
+        if (it == streams_.end() || !it->second.readable)
+            continue;
+
+        it->second.readable = false;
+        receive_data(handler, token);
+    }
+
+    still_readable_.clear();
+
+    for (auto &event : events_)
+    {
+        if (event.token == listener_token)
+        {
+            accept_clients(handler);
+            continue;
+        }
+
+        if (event.events & event_flags::ev_write)
+            flush(event.token);
+
+        if (event.events & (event_flags::ev_read | event_flags::ev_closed))
+            receive_data(handler, event.token);
+    }
+
+    report_failures(handler);
+}
+
+void poll_engine::wake()
+{
+    loop_.wake();
+}
+
+void poll_engine::set_coalescing(std::chrono::microseconds window, std::size_t min_bytes)
+{
+    coalescing_window_ = window;
+    coalescing_bytes_ = min_bytes;
+}
+
+void poll_engine::set_write_limits(const write_limits &limits)
+{
+    limits_ = limits;
+}
+
+void poll_engine::accept_clients(io_handler &handler)
+{
+    while (listener_ != INVALID_SOCKET)
+    {
+#ifdef __linux__
+        // the socket is non-blocking and close-on-exec from the moment it exists, no descriptor leaks into a child
+        auto client = accept4(listener_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+        auto client = accept(listener_, nullptr, nullptr);
+#endif
+
+        if (client == INVALID_SOCKET)
+        {
+            if (last_error_interrupted())
+                continue;
+
+            break;
+        }
+
+#ifndef __linux__
+        if (!set_non_blocking(client))
+        {
+            closesocket(client);
+            continue;
+        }
+#endif
+
+        handler.on_accept(client);
+    }
+}
+
+void poll_engine::receive_data(io_handler &handler, std::uint64_t token)
+{
+    std::uint32_t reads = 0;
+    std::size_t bytes = 0;
+
+    while (true)
+    {
+        auto it = streams_.find(token);
+
+        // a stream paused while its data was being handled is read again once the event loop re-arms it, one already
+        // waiting on readable_ keeps its place there
+        if (it == streams_.end() || it->second.reading_paused || it->second.readable)
+            return;
+
+        // a peer that refills its socket as fast as it is drained would otherwise keep the loop here, starving every
+        // other stream, accepts, posted work and deadlines of this engine
+        if (reads == max_reads_per_pass_ || bytes >= max_bytes_per_pass_)
+        {
+            it->second.readable = true;
+            readable_.push_back(token);
+
+            return;
+        }
+
+        auto space = it->second.closing ? std::span<std::uint8_t>() : handler.receive_space(token);
+        bool in_place = !space.empty();
+
+        if (!in_place)
+            space = std::span(receive_buffer_);
+
+        int bytes_received = recv(it->second.socket, reinterpret_cast<char *>(space.data()), static_cast<int>(std::min<std::size_t>(space.size(), INT_MAX)), 0);
+
+        if (bytes_received > 0)
+        {
+            reads++;
+            bytes += bytes_received;
+
+            if (!it->second.closing)
+                handler.on_receive(token, space.data(), bytes_received);
+
+            if (!in_place)
+                fit_receive_buffer(bytes_received);
+
+            continue;
+        }
+
+        if (bytes_received < 0 && last_error_interrupted())
+            continue;
+
+        if (bytes_received < 0 && last_error_would_block())
+            return;
+
+        bool closing = it->second.closing;
+        release(token);
+
+        if (!closing)
+            handler.on_close(token);
+
+        return;
+    }
+}
+
+void poll_engine::fit_receive_buffer(std::size_t received)
+{
+    if (received == receive_buffer_.size() && received < max_buffer_size_)
+    {
+        receive_buffer_.resize(received * 2);
+        small_reads_ = 0;
+    }
+    else if (received < receive_buffer_.size() / 4 && receive_buffer_.size() > min_buffer_size_)
+    {
+        if (++small_reads_ < shrink_after_)
+            return;
+
+        receive_buffer_.resize(receive_buffer_.size() / 2);
+        receive_buffer_.shrink_to_fit();
+        small_reads_ = 0;
+    }
+    else
+        small_reads_ = 0;
+}
+
+poll_engine::stream *poll_engine::writable_stream(std::uint64_t token)
+{
+    auto it = streams_.find(token);
+
+    if (it == streams_.end() || it->second.closing)
+        return nullptr;
+
+    return &it->second;
+}
+
+void poll_engine::mark_pending(std::uint64_t token, stream &s)
+{
+    // a stream waiting for writability is flushed by the event loop, anything else on the next pass
+    if (s.write_armed || s.pending)
+        return;
+
+    s.pending = true;
+    s.queued_at = std::chrono::steady_clock::now();
+
+    pending_.push_back(token);
+}
+
+void poll_engine::flush(std::uint64_t token)
+{
+    auto it = streams_.find(token);
+
+    if (it == streams_.end())
+        return;
+
+    auto &s = it->second;
+    io_slice slices[max_slices_];
+
+    s.pending = false;
+
+    while (!s.outbound.empty())
+    {
+        auto sent = send_slices(s.socket, slices, s.outbound.gather(slices, max_slices_));
+
+        if (sent > 0)
+        {
+            s.outbound.advance(static_cast<std::size_t>(sent));
+            total_pending_ -= static_cast<std::size_t>(sent);
+
+            apply_limits(token, s);
+            continue;
+        }
+
+        if (sent < 0 && last_error_interrupted())
+            continue;
+
+        if (sent < 0 && last_error_would_block())
+        {
+            if (!s.write_armed)
+            {
+                s.write_armed = true;
+                update_interest(token, s);
+            }
+
+            return;
+        }
+
+        if (!s.closing)
+            failed_.push_back(token);
+
+        release(token);
+        return;
+    }
+
+    if (s.write_armed)
+    {
+        s.write_armed = false;
+        update_interest(token, s);
+    }
+
+    if (s.closing)
+        release(token);
+}
+
+int poll_engine::flush_pending()
+{
+    auto now = std::chrono::steady_clock::now();
+    auto next_deadline = std::chrono::steady_clock::time_point::max();
+
+    still_pending_.clear();
+
+    for (auto token : pending_)
+    {
+        auto it = streams_.find(token);
+
+        if (it == streams_.end() || !it->second.pending)
+            continue;
+
+        auto &s = it->second;
+        auto deadline = s.queued_at + coalescing_window_;
+
+        if (!s.closing && !s.write_armed && s.outbound.pending() < coalescing_bytes_ && now < deadline)
+        {
+            still_pending_.push_back(token);
+            next_deadline = std::min(next_deadline, deadline);
+            continue;
+        }
+
+        flush(token);
+    }
+
+    pending_.swap(still_pending_);
+
+    if (pending_.empty())
+        return -1;
+
+    return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(next_deadline - now).count());
+}
+
+bool poll_engine::apply_limits(std::uint64_t token, stream &s)
+{
+    auto pending = s.outbound.pending();
+
+    // a peer that stopped reading must not be able to grow the process without bound
+    if (limits_.max && pending > limits_.max)
+    {
+        failed_.push_back(token);
+        release(token);
+
+        return false;
+    }
+
+    if (limits_.high && !s.congested && pending >= limits_.high)
+    {
+        s.congested = true;
+        congestion_.push_back({token, true});
+        update_interest(token, s);
+    }
+    else if (s.congested && pending <= limits_.low)
+    {
+        s.congested = false;
+        congestion_.push_back({token, false});
+        update_interest(token, s);
+    }
+
+    apply_total_limit();
+
+    return true;
+}
+
+void poll_engine::apply_total_limit()
+{
+    if (!limits_.total)
+        return;
+
+    bool congested = total_congested_ ? total_pending_ > limits_.total / 2 : total_pending_ >= limits_.total;
+
+    if (congested == total_congested_)
+        return;
+
+    total_congested_ = congested;
+
+    for (auto &[token, s] : streams_)
+        update_interest(token, s);
+}
+
+void poll_engine::update_interest(std::uint64_t token, stream &s)
+{
+    s.reading_paused = s.congested || s.read_held || total_congested_;
+
+    std::uint32_t events = s.reading_paused ? event_flags::ev_none : event_flags::ev_read;
+
+    if (s.write_armed)
+        events |= event_flags::ev_write;
+
+    // re-arming an edge-triggered socket reports data that arrived while reading was paused
+    loop_.modify(s.socket, token, events);
+}
+
+void poll_engine::release(std::uint64_t token)
+{
+    auto it = streams_.find(token);
+
+    if (it == streams_.end())
+        return;
+
+    loop_.remove(it->second.socket);
+    ::shutdown(it->second.socket, SD_SEND);
+    closesocket(it->second.socket);
+
+    total_pending_ -= it->second.outbound.pending();
+    streams_.erase(it);
+
+    apply_total_limit();
+}
+
+void poll_engine::report_failures(io_handler &handler)
+{
+    for (std::size_t i = 0; i < congestion_.size(); i++)
+    {
+        if (streams_.find(congestion_[i].token) != streams_.end())
+            handler.on_congestion(congestion_[i].token, congestion_[i].congested);
+    }
+
+    congestion_.clear();
+
+    while (!failed_.empty())
+    {
+        auto token = failed_.back();
+        failed_.pop_back();
+
+        handler.on_close(token);
+    }
+}
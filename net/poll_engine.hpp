@@ -0,0 +1,112 @@
+#ifndef POLL_ENGINE_H
+#define POLL_ENGINE_H
+
+#include <chrono>
+#include <climits>
+#include <unordered_map>
+#include <vector>
+#include "event_loop.hpp"
+#include "buffer_pool.hpp"
+#include "outbound_queue.hpp"
+#include "io_handler.hpp"
+
+namespace acc::net
+{
+    // readiness based engine: reads and writes are issued by the engine itself once the event loop reports a socket as ready
+    class poll_engine
+    {
+    public:
+        static constexpr std::uint64_t listener_token = event_loop::wake_token - 1;
+
+        poll_engine() = default;
+        ~poll_engine();
+
+        poll_engine(const poll_engine &) = delete;
+        poll_engine &operator=(const poll_engine &) = delete;
+
+        bool open();
+        void close();
+
+        bool listen(SOCKET listener);
+        bool attach(SOCKET s, std::uint64_t token);
+        bool write(std::uint64_t token, std::vector<std::uint8_t> &&data);
+        bool write(std::uint64_t token, const shared_frame &frame);
+        void shutdown(std::uint64_t token);
+        void abort(std::uint64_t token);
+        bool is_attached(std::uint64_t token);
+
+        // a held stream is not read from until released, on top of any pause caused by its write limits
+        void hold_reading(std::uint64_t token, bool held);
+
+        // lifetime byte counts of a stream's outbound queue, false if the stream is not attached
+        bool get_progress(std::uint64_t token, std::uint64_t &queued, std::uint64_t &sent);
+
+        void run_once(io_handler &handler, int timeout_ms);
+        void wake();
+
+        // writes queued while handling one batch of events go out together in one vectored send per stream. a window
+        // additionally holds back streams with fewer than min_bytes pending until it expires
+        void set_coalescing(std::chrono::microseconds window, std::size_t min_bytes);
+        void set_write_limits(const write_limits &limits);
+
+    private:
+        struct stream
+        {
+            SOCKET socket = INVALID_SOCKET;
+            outbound_queue outbound = {};
+            std::chrono::steady_clock::time_point queued_at = {};
+            bool write_armed = false, pending = false, closing = false;
+            bool congested = false, read_held = false, reading_paused = false;
+            bool readable = false;
+        };
+
+        struct congestion_event
+        {
+            std::uint64_t token = 0;
+            bool congested = false;
+        };
+
+        void accept_clients(io_handler &handler);
+        void receive_data(io_handler &handler, std::uint64_t token);
+        void fit_receive_buffer(std::size_t received);
+        stream *writable_stream(std::uint64_t token);
+        void mark_pending(std::uint64_t token, stream &s);
+        void flush(std::uint64_t token);
+        int flush_pending();
+        bool apply_limits(std::uint64_t token, stream &s);
+        void apply_total_limit();
+        void update_interest(std::uint64_t token, stream &s);
+        void release(std::uint64_t token);
+        void report_failures(io_handler &handler);
+
+        // the receive buffer doubles after a read that filled it and halves after a run of reads that used little of it
+        static constexpr std::size_t min_buffer_size_ = 4 * 1024, max_buffer_size_ = 256 * 1024;
+        static constexpr std::uint32_t shrink_after_ = 64;
+        static constexpr std::size_t max_slices_ = 64;
+
+        // a stream is read at most this much per pass, whatever is left waits on readable_ for the next one
+        static constexpr std::uint32_t max_reads_per_pass_ = 16;
+        static constexpr std::size_t max_bytes_per_pass_ = 256 * 1024;
+
+        event_loop loop_ = {};
+        SOCKET listener_ = INVALID_SOCKET;
+
+        std::unordered_map<std::uint64_t, stream> streams_ = {};
+        std::vector<std::uint64_t> failed_ = {}, pending_ = {}, still_pending_ = {};
+        std::vector<std::uint64_t> readable_ = {}, still_readable_ = {};
+
+        std::chrono::microseconds coalescing_window_ = {};
+        std::size_t coalescing_bytes_ = 0;
+
+        write_limits limits_ = {};
+        std::size_t total_pending_ = 0;
+        bool total_congested_ = false;
+        std::vector<congestion_event> congestion_ = {};
+
+        std::vector<io_event> events_ = {};
+        std::vector<std::uint8_t> receive_buffer_ = {};
+        std::uint32_t small_reads_ = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef SLOT_TABLE_H
+#define SLOT_TABLE_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace acc::net
+{
+    // keeps values in a flat array of slots, each tagged with a generation that advances whenever its slot is freed so
+    // a handle to an erased value can be told apart from whatever took its slot later. insert, find and erase are O(1).
+    // freed slots are reused oldest first, which keeps any one slot's generation from wrapping around quickly
+    template <typename T, unsigned int GenerationBits = 32>
+    class slot_table
+    {
+        static_assert(GenerationBits >= 1 && GenerationBits <= 32, "generation must fit in 32 bits");
+
+    public:
+        struct handle
+        {
+            std::uint32_t slot = 0;
+            std::uint32_t generation = 0;
+        };
+
+        // the value is default constructed, generations start at 1 so a zeroed handle never matches
+        handle insert()
+        {
+            if (free_.empty())
+            {
+                slots_.push_back({});
+                slots_.back().generation = 1;
+                free_.push_back(static_cast<std::uint32_t>(slots_.size() - 1));
+            }
+
+            auto index = free_.front();
+            free_.pop_front();
+
+            auto &entry = slots_[index];
+            entry.occupied = true;
+            count_++;
+
+            return {index, entry.generation};
+        }
+
+        T *find(handle h)
+        {
+            if (h.slot >= slots_.size())
+                return nullptr;
+
+            auto &entry = slots_[h.slot];
+            return entry.occupied && entry.generation == h.generation ? &entry.value : nullptr;
+        }
+
+        bool erase(handle h)
+        {
+            if (!find(h))
+                return false;
+
+            auto &entry = slots_[h.slot];
+
+            entry.value = T{};
+            entry.occupied = false;
+            entry.generation = entry.generation == max_generation ? 1 : entry.generation + 1;
+
+            free_.push_back(h.slot);
+            count_--;
+
+            return true;
+        }
+
+        std::size_t size() const
+        {
+            return count_;
+        }
+
+        static constexpr std::uint32_t max_generation = GenerationBits == 32 ? UINT32_MAX : (1u << GenerationBits) - 1;
+
+    private:
+        struct entry
+        {
+            T value = {};
+            std::uint32_t generation = 0;
+            bool occupied = false;
+        };
+
+        std::vector<entry> slots_ = {};
+        std::deque<std::uint32_t> free_ = {};
+        std::size_t count_ = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace acc::net
+{
+    template <typename T = void>
+    class task;
+
+    namespace detail
+    {
+        struct task_promise_base
+        {
+            std::coroutine_handle<> continuation = nullptr;
+            std::exception_ptr error = nullptr;
+            bool detached = false;
+
+            struct final_awaiter
+            {
+                bool await_ready() noexcept
+                {
+                    return false;
+                }
+
+                template <typename P>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept
+                {
+                    auto &promise = handle.promise();
+
+                    if (promise.continuation)
+                        return promise.continuation;
+
+                    // a started task owns itself, nobody is left to rethrow its exception
+                    if (promise.detached)
+                    {
+                        if (promise.error)
+                            std::terminate();
+
+                        handle.destroy();
+                    }
+
+                    return std::noop_coroutine();
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            final_awaiter final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void unhandled_exception()
+            {
+                error = std::current_exception();
+            }
+        };
+
+        template <typename T>
+        struct task_promise : task_promise_base
+        {
+            std::optional<T> value = std::nullopt;
+
+            task<T> get_return_object();
+
+            template <typename U>
+            void return_value(U &&result)
+            {
+                value.emplace(std::forward<U>(result));
+            }
+
+            T take()
+            {
+                if (error)
+                    std::rethrow_exception(error);
+
+                return std::move(*value);
+            }
+        };
+
+        template <>
+        struct task_promise<void> : task_promise_base
+        {
+            task<void> get_return_object();
+
+            void return_void() {}
+
+            void take()
+            {
+                if (error)
+                    std::rethrow_exception(error);
+            }
+        };
+    }
+
+    // lazily started coroutine. awaiting it runs it to completion and resumes the awaiter from wherever it finished,
+    // start() runs it on the calling thread until it first suspends and leaves it to finish on its own. awaitables of
+    // the client and server resume on the thread that owns the connection, as callbacks would run
+    template <typename T>
+    class task
+    {
+    public:
+        typedef detail::task_promise<T> promise_type;
+
+        task() = default;
+        explicit task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+        task(task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+        task &operator=(task &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (handle_)
+                    handle_.destroy();
+
+                handle_ = std::exchange(other.handle_, nullptr);
+            }
+
+            return *this;
+        }
+
+        task(const task &) = delete;
+        task &operator=(const task &) = delete;
+
+        ~task()
+        {
+            if (handle_)
+                handle_.destroy();
+        }
+
+        void start()
+        {
+            auto handle = std::exchange(handle_, nullptr);
+
+            handle.promise().detached = true;
+            handle.resume();
+        }
+
+        auto operator co_await() && noexcept
+        {
+            struct awaiter
+            {
+                std::coroutine_handle<promise_type> handle = nullptr;
+
+                bool await_ready() noexcept
+                {
+                    return false;
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+                {
+                    handle.promise().continuation = awaiting;
+                    return handle;
+                }
+
+                T await_resume()
+                {
+                    return handle.promise().take();
+                }
+            };
+
+            return awaiter{handle_};
+        }
+
+    private:
+        std::coroutine_handle<promise_type> handle_ = nullptr;
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        task<T> task_promise<T>::get_return_object()
+        {
+            return task<T>(std::coroutine_handle<task_promise<T>>::from_promise(*this));
+        }
+
+        inline task<void> task_promise<void>::get_return_object()
+        {
+            return task<void>(std::coroutine_handle<task_promise<void>>::from_promise(*this));
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace acc::net
+{
+    // hierarchical timing wheel. scheduling is O(1) no matter how many timers are live, expired timers are found
+    // without scanning the others, and each timer is moved down a level at most levels_ - 1 times. there is no cancel:
+    // owners validate a timer when it fires and simply ignore stale ones
+    template <typename T>
+    class timer_wheel
+    {
+    public:
+        typedef std::chrono::steady_clock clock;
+
+        timer_wheel() : timer_wheel(std::chrono::milliseconds(10)) {}
+        explicit timer_wheel(std::chrono::milliseconds tick) : tick_(tick), origin_(clock::now()) {}
+
+        timer_wheel(const timer_wheel &) = delete;
+        timer_wheel &operator=(const timer_wheel &) = delete;
+
+        bool empty() const
+        {
+            return count_ == 0;
+        }
+
+        void schedule(clock::time_point when, const T &value)
+        {
+            // rounded up, a timer never fires before its deadline
+            auto milliseconds = std::chrono::ceil<std::chrono::milliseconds>(when - origin_).count();
+            auto ticks = (milliseconds + tick_.count() - 1) / tick_.count();
+            auto expiry = ticks > static_cast<long long>(current_) ? static_cast<std::uint64_t>(ticks) : current_ + 1;
+
+            insert({expiry, value});
+            count_++;
+        }
+
+        // fires every timer that is due by now, fire may schedule new timers
+        template <typename F>
+        void advance(clock::time_point now, F &&fire)
+        {
+            auto target = static_cast<std::uint64_t>((now - origin_) / tick_);
+
+            if (!count_)
+            {
+                current_ = std::max(current_, target);
+                return;
+            }
+
+            while (current_ < target)
+            {
+                current_++;
+
+                // entries of a higher level slot move down once the lower levels have wrapped around to it
+                for (std::size_t level = 1; level < levels_ && !(current_ & mask(level)); level++)
+                    cascade(level);
+
+                firing_.swap(slots_[0][current_ & slot_mask_]);
+
+                count_ -= firing_.size();
+
+                for (auto &e : firing_)
+                    fire(e.value);
+
+                firing_.clear();
+
+                if (!count_)
+                {
+                    current_ = target;
+                    return;
+                }
+            }
+        }
+
+        // milliseconds until the next tick that may fire a timer, -1 if none are scheduled
+        int next_timeout(clock::time_point now) const
+        {
+            if (!count_)
+                return -1;
+
+            // a timer in a higher level is not due before the lowest level has wrapped around
+            auto next = (current_ | slot_mask_) + 1;
+
+            for (auto t = current_ + 1; t < next; t++)
+            {
+                if (!slots_[0][t & slot_mask_].empty())
+                {
+                    next = t;
+                    break;
+                }
+            }
+
+            auto wait = origin_ + next * tick_ - now;
+
+            return std::max(0, static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(wait).count()));
+        }
+
+    private:
+        static constexpr std::size_t levels_ = 4;
+        static constexpr std::size_t slot_bits_ = 6;
+        static constexpr std::uint64_t slot_mask_ = (1ull << slot_bits_) - 1;
+
+        struct entry
+        {
+            std::uint64_t expiry = 0;
+            T value = {};
+        };
+
+        static constexpr std::uint64_t mask(std::size_t level)
+        {
+            return (1ull << (slot_bits_ * level)) - 1;
+        }
+
+        void insert(entry &&e)
+        {
+            // deadlines beyond the wheel's range wait in the furthest slot and are placed again once it comes due
+            auto position = std::min(e.expiry, current_ + mask(levels_));
+            auto delta = position - current_;
+            std::size_t level = 0;
+
+            while (level + 1 < levels_ && delta > mask(level + 1))
+                level++;
+
+            slots_[level][(position >> (slot_bits_ * level)) & slot_mask_].push_back(std::move(e));
+        }
+
+        void cascade(std::size_t level)
+        {
+            cascading_.swap(slots_[level][(current_ >> (slot_bits_ * level)) & slot_mask_]);
+
+            for (auto &e : cascading_)
+            {
+                if (e.expiry <= current_)
+                    slots_[0][current_ & slot_mask_].push_back(std::move(e));
+                else
+                    insert(std::move(e));
+            }
+
+            cascading_.clear();
+        }
+
+        const std::chrono::milliseconds tick_;
+        const clock::time_point origin_;
+
+        std::uint64_t current_ = 0;
+        std::size_t count_ = 0;
+
+        std::array<std::array<std::vector<entry>, slot_mask_ + 1>, levels_> slots_ = {};
+        std::vector<entry> firing_ = {}, cascading_ = {};
+    };
+}
+
+#endif
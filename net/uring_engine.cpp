@@ -0,0 +1,883 @@
+#ifdef ACC_USE_IO_URING
+
+#include "uring_engine.hpp"
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <csignal>
+#include <ctime>
+
+using namespace acc::net;
+
+namespace
+{
+    constexpr int operation_shift = 56;
+    constexpr std::uint64_t id_mask = (1ull << operation_shift) - 1;
+
+    std::uint64_t encode_user_data(std::uint8_t operation, std::uint64_t id)
+    {
+        return (static_cast<std::uint64_t>(operation) << operation_shift) | (id & id_mask);
+    }
+
+    int io_uring_setup(unsigned int entries, io_uring_params *params)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int io_uring_enter(int ring_fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags, void *arg, std::size_t arg_size)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, arg_size));
+    }
+
+    int io_uring_register(int ring_fd, unsigned int opcode, void *arg, unsigned int nr_args)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+    }
+}
+
+uring_engine::~uring_engine()
+{
+    close();
+}
+
+bool uring_engine::open()
+{
+    io_uring_params params = {};
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+    params.cq_entries = queue_depth_ * 8;
+
+    ring_fd_ = io_uring_setup(queue_depth_, &params);
+
+    if (ring_fd_ < 0)
+    {
+        ring_fd_ = -1;
+        return false;
+    }
+
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP))
+    {
+        close();
+        return false;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    if (cq_ring_size_ > sq_ring_size_)
+        sq_ring_size_ = cq_ring_size_;
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+
+    if (sq_ring_ == MAP_FAILED)
+    {
+        sq_ring_ = nullptr;
+        close();
+        return false;
+    }
+
+    cq_ring_ = sq_ring_;
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    auto sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+
+    if (sqes == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+
+    sqes_ = reinterpret_cast<io_uring_sqe *>(sqes);
+
+    auto sq_base = reinterpret_cast<std::uint8_t *>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned int *>(sq_base + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned int *>(sq_base + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned int *>(sq_base + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned int *>(sq_base + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+
+    auto cq_base = reinterpret_cast<std::uint8_t *>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned int *>(cq_base + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned int *>(cq_base + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned int *>(cq_base + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq_base + params.cq_off.cqes);
+
+    for (unsigned int i = 0; i < sq_entries_; i++)
+        sq_array_[i] = i;
+
+    sqe_tail_ = submitted_tail_ = *sq_tail_;
+
+    buffers_.resize(static_cast<std::size_t>(buffer_count_) * buffer_size_);
+
+    // kernels without buffer rings still support the classic provided buffer group
+    if (!register_buffer_ring())
+        provide_buffers(0, buffer_count_);
+
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (wake_fd_ == -1)
+    {
+        close();
+        return false;
+    }
+
+    submit_wake_read();
+
+    return enter(0, 0);
+}
+
+void uring_engine::close()
+{
+    while (!streams_.empty())
+        release(streams_.begin()->first);
+
+    listener_ = INVALID_SOCKET;
+
+    // sends still referencing retired buffers have been cut short by the shutdowns above, so wait briefly for them
+    for (int attempts = 0; ring_fd_ != -1 && !retired_sends_.empty() && attempts < 100; attempts++)
+    {
+        if (!enter(1, 10))
+            break;
+
+        auto head = *cq_head_;
+        auto tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+        for (; head != tail; head++)
+        {
+            auto &cqe = cqes_[head & *cq_mask_];
+
+            if ((cqe.user_data >> operation_shift) == op_send)
+                retired_sends_.erase(cqe.user_data & id_mask);
+        }
+
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+
+    unregister_buffer_ring();
+
+    if (sqes_)
+    {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+
+    if (sq_ring_)
+    {
+        munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = cq_ring_ = nullptr;
+    }
+
+    if (ring_fd_ != -1)
+    {
+        ::close(ring_fd_);
+        ring_fd_ = -1;
+    }
+
+    if (wake_fd_ != -1)
+    {
+        ::close(wake_fd_);
+        wake_fd_ = -1;
+    }
+
+    retired_sends_.clear();
+    stream_ids_.clear();
+    failed_.clear();
+    congestion_.clear();
+    buffers_.clear();
+}
+
+bool uring_engine::listen(SOCKET listener)
+{
+    listener_ = listener;
+    submit_accept();
+
+    return true;
+}
+
+bool uring_engine::attach(SOCKET s, std::uint64_t token)
+{
+    if (stream_ids_.find(token) != stream_ids_.end() || !set_non_blocking(s))
+        return false;
+
+    auto id = next_stream_id_++ & id_mask;
+
+    auto &new_stream = streams_[id];
+    new_stream.socket = s;
+    new_stream.token = token;
+
+    stream_ids_[token] = id;
+
+    submit_receive(id, new_stream);
+
+    return true;
+}
+
+bool uring_engine::write(std::uint64_t token, std::vector<std::uint8_t> &&data)
+{
+    std::uint64_t id = 0;
+    auto s = writable_stream(token, id);
+
+    if (!s)
+        return false;
+
+    if (data.empty())
+        return true;
+
+    total_pending_ += data.size();
+    s->outbound.push_back(std::move(data));
+
+    if (!apply_limits(id, *s))
+        return false;
+
+    mark_pending(id, *s);
+
+    return true;
+}
+
+bool uring_engine::write(std::uint64_t token, const shared_frame &frame)
+{
+    std::uint64_t id = 0;
+    auto s = writable_stream(token, id);
+
+    if (!s)
+        return false;
+
+    if (frame->empty())
+        return true;
+
+    total_pending_ += frame->size();
+    s->outbound.push_back(frame);
+
+    if (!apply_limits(id, *s))
+        return false;
+
+    mark_pending(id, *s);
+
+    return true;
+}
+
+void uring_engine::shutdown(std::uint64_t token)
+{
+    auto it = stream_ids_.find(token);
+
+    if (it == stream_ids_.end())
+        return;
+
+    auto &s = streams_[it->second];
+    s.closing = true;
+
+    if (s.send_in_flight)
+        return;
+
+    if (s.outbound.empty())
+        release(it->second);
+    else
+        mark_pending(it->second, s);
+}
+
+void uring_engine::hold_reading(std::uint64_t token, bool held)
+{
+    auto it = stream_ids_.find(token);
+
+    if (it == stream_ids_.end())
+        return;
+
+    auto &s = streams_[it->second];
+    s.read_held = held;
+
+    update_reading(it->second, s);
+}
+
+void uring_engine::abort(std::uint64_t token)
+{
+    auto it = stream_ids_.find(token);
+
+    if (it != stream_ids_.end())
+        release(it->second);
+}
+
+bool uring_engine::is_attached(std::uint64_t token)
+{
+    return stream_ids_.find(token) != stream_ids_.end();
+}
+
+bool uring_engine::get_progress(std::uint64_t token, std::uint64_t &queued, std::uint64_t &sent)
+{
+    auto it = stream_ids_.find(token);
+
+    if (it == stream_ids_.end())
+        return false;
+
+    auto &s = streams_[it->second];
+
+    queued = s.outbound.queued();
+    sent = s.outbound.sent();
+
+    return true;
+}
+
+void uring_engine::run_once(io_handler &handler, int timeout_ms)
+{
+    auto flush_timeout = flush_pending();
+
+    if (flush_timeout >= 0 && (timeout_ms < 0 || flush_timeout < timeout_ms))
+        timeout_ms = flush_timeout;
+
+    report_failures(handler);
+
+    bool has_completions = *cq_head_ != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+    enter(has_completions || !failed_.empty() ? 0 : 1, timeout_ms);
+
+    auto head = *cq_head_;
+    auto tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+    completions_.clear();
+
+    for (; head != tail; head++)
+        completions_.push_back(cqes_[head & *cq_mask_]);
+
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+    for (auto &cqe : completions_)
+        handle_completion(handler, cqe);
+
+    report_failures(handler);
+}
+
+void uring_engine::wake()
+{
+    std::uint64_t signal = 1;
+    [[maybe_unused]] auto written = ::write(wake_fd_, &signal, sizeof(signal));
+}
+
+void uring_engine::set_coalescing(std::chrono::microseconds window, std::size_t min_bytes)
+{
+    coalescing_window_ = window;
+    coalescing_bytes_ = min_bytes;
+}
+
+void uring_engine::set_write_limits(const write_limits &limits)
+{
+    limits_ = limits;
+}
+
+io_uring_sqe *uring_engine::get_sqe()
+{
+    if (sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_)
+    {
+        // submission queue is full, hand what we have to the kernel to make room
+        enter(0, 0);
+
+        if (sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_)
+            return nullptr;
+    }
+
+    auto sqe = &sqes_[sqe_tail_ & *sq_mask_];
+    *sqe = {};
+
+    sqe_tail_++;
+
+    return sqe;
+}
+
+bool uring_engine::enter(unsigned int min_complete, int timeout_ms)
+{
+    __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+
+    auto to_submit = sqe_tail_ - submitted_tail_;
+
+    __kernel_timespec timeout = {};
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+
+    io_uring_getevents_arg arg = {};
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = timeout_ms >= 0 ? reinterpret_cast<std::uint64_t>(&timeout) : 0;
+
+    unsigned int flags = IORING_ENTER_EXT_ARG | (min_complete ? IORING_ENTER_GETEVENTS : 0);
+
+    int result = io_uring_enter(ring_fd_, to_submit, min_complete, flags, &arg, sizeof(arg));
+
+    if (result >= 0)
+        submitted_tail_ += static_cast<unsigned int>(result);
+
+    return result >= 0 || errno == ETIME || errno == EINTR || errno == EBUSY;
+}
+
+void uring_engine::submit_accept()
+{
+    auto sqe = get_sqe();
+
+    if (!sqe)
+        return;
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listener_;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = encode_user_data(op_accept, 0);
+}
+
+void uring_engine::submit_receive(std::uint64_t id, stream &s)
+{
+    auto sqe = get_sqe();
+
+    if (!sqe)
+    {
+        failed_.push_back(s.token);
+        release(id);
+        return;
+    }
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = s.socket;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = buffer_group_;
+    sqe->user_data = encode_user_data(op_receive, id);
+
+    s.receive_armed = true;
+    s.ring_receive = buffer_ring_ != nullptr;
+}
+
+void uring_engine::submit_cancel_receive(std::uint64_t id)
+{
+    auto sqe = get_sqe();
+
+    // without a free entry the receive stays armed and reading simply is not paused
+    if (!sqe)
+        return;
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = encode_user_data(op_receive, id);
+    sqe->user_data = encode_user_data(op_cancel, id);
+}
+
+void uring_engine::submit_send(std::uint64_t id, stream &s)
+{
+    auto sqe = get_sqe();
+
+    if (!sqe)
+    {
+        if (!s.closing)
+            failed_.push_back(s.token);
+
+        release(id);
+        return;
+    }
+
+    if (!s.send)
+        s.send = std::make_unique<send_message>();
+
+    s.send->message.msg_iov = s.send->slices;
+    s.send->message.msg_iovlen = s.outbound.gather(s.send->slices, max_slices_);
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = s.socket;
+    sqe->addr = reinterpret_cast<std::uint64_t>(&s.send->message);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = encode_user_data(op_send, id);
+
+    s.pending = false;
+    s.send_in_flight = true;
+}
+
+uring_engine::stream *uring_engine::writable_stream(std::uint64_t token, std::uint64_t &id)
+{
+    auto it = stream_ids_.find(token);
+
+    if (it == stream_ids_.end())
+        return nullptr;
+
+    auto &s = streams_[it->second];
+
+    if (s.closing)
+        return nullptr;
+
+    id = it->second;
+    return &s;
+}
+
+void uring_engine::mark_pending(std::uint64_t id, stream &s)
+{
+    // while a send is in flight its completion picks up whatever was queued meanwhile
+    if (s.send_in_flight || s.pending)
+        return;
+
+    s.pending = true;
+    s.queued_at = std::chrono::steady_clock::now();
+
+    pending_.push_back(id);
+}
+
+int uring_engine::flush_pending()
+{
+    auto now = std::chrono::steady_clock::now();
+    auto next_deadline = std::chrono::steady_clock::time_point::max();
+
+    still_pending_.clear();
+
+    for (auto id : pending_)
+    {
+        auto it = streams_.find(id);
+
+        if (it == streams_.end() || !it->second.pending)
+            continue;
+
+        auto &s = it->second;
+        auto deadline = s.queued_at + coalescing_window_;
+
+        if (s.send_in_flight || s.outbound.empty())
+        {
+            s.pending = false;
+            continue;
+        }
+
+        if (!s.closing && s.outbound.pending() < coalescing_bytes_ && now < deadline)
+        {
+            still_pending_.push_back(id);
+            next_deadline = std::min(next_deadline, deadline);
+            continue;
+        }
+
+        submit_send(id, s);
+    }
+
+    pending_.swap(still_pending_);
+
+    if (pending_.empty())
+        return -1;
+
+    return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(next_deadline - now).count());
+}
+
+void uring_engine::submit_wake_read()
+{
+    auto sqe = get_sqe();
+
+    if (!sqe)
+        return;
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = wake_fd_;
+    sqe->addr = reinterpret_cast<std::uint64_t>(&wake_value_);
+    sqe->len = sizeof(wake_value_);
+    sqe->user_data = encode_user_data(op_wake, 0);
+}
+
+void uring_engine::handle_completion(io_handler &handler, const io_uring_cqe &cqe)
+{
+    auto operation = static_cast<std::uint8_t>(cqe.user_data >> operation_shift);
+    auto id = cqe.user_data & id_mask;
+    bool more = cqe.flags & IORING_CQE_F_MORE;
+
+    switch (operation)
+    {
+    case op_accept:
+        if (listener_ == INVALID_SOCKET)
+        {
+            if (cqe.res >= 0)
+                closesocket(cqe.res);
+
+            break;
+        }
+
+        if (cqe.res >= 0)
+            handler.on_accept(cqe.res);
+
+        if (!more && cqe.res != -EBADF && cqe.res != -EINVAL && cqe.res != -ENOTSOCK && cqe.res != -ECANCELED)
+            submit_accept();
+
+        break;
+    case op_receive:
+    {
+        auto it = streams_.find(id);
+
+        if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER))
+        {
+            buffer_ring_verified_ = true;
+
+            auto buffer_id = static_cast<std::uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+
+            if (it != streams_.end() && !it->second.closing)
+                handler.on_receive(it->second.token, buffers_.data() + static_cast<std::size_t>(buffer_id) * buffer_size_, cqe.res);
+
+            recycle_buffer(buffer_id);
+
+            // the handler may have released the stream
+            it = streams_.find(id);
+        }
+
+        // a ring that is full yet never hands out a usable buffer is broken on this kernel, fall back to the classic group
+        bool ring_unusable = (cqe.res == -ENOBUFS || cqe.res == -EFAULT) && buffer_ring_ && !buffer_ring_verified_;
+
+        if (ring_unusable)
+        {
+            unregister_buffer_ring();
+            provide_buffers(0, buffer_count_);
+        }
+
+        if (it == streams_.end())
+            break;
+
+        if (!more)
+            it->second.receive_armed = false;
+
+        // every receive armed against the ring fails the same way, not just the one that noticed it was unusable
+        bool ring_dropped = cqe.res == -EFAULT && it->second.ring_receive && !buffer_ring_;
+
+        // a receive cancelled to pause reading is submitted again once reading resumes
+        if (cqe.res > 0 || cqe.res == -ENOBUFS || cqe.res == -ECANCELED || ring_unusable || ring_dropped)
+        {
+            if (!more && !it->second.reading_paused)
+                submit_receive(id, it->second);
+
+            break;
+        }
+
+        auto token = it->second.token;
+        bool closing = it->second.closing;
+        release(id);
+
+        if (!closing)
+            handler.on_close(token);
+
+        break;
+    }
+    case op_send:
+    {
+        auto it = streams_.find(id);
+
+        if (it == streams_.end())
+        {
+            retired_sends_.erase(id);
+            break;
+        }
+
+        auto &s = it->second;
+        s.send_in_flight = false;
+
+        if (cqe.res <= 0)
+        {
+            if (!s.closing)
+                failed_.push_back(s.token);
+
+            release(id);
+            break;
+        }
+
+        s.outbound.advance(static_cast<std::size_t>(cqe.res));
+        total_pending_ -= static_cast<std::size_t>(cqe.res);
+
+        apply_limits(id, s);
+
+        if (!s.outbound.empty())
+            submit_send(id, s);
+        else if (s.closing)
+            release(id);
+
+        break;
+    }
+    case op_wake:
+        submit_wake_read();
+        break;
+    }
+}
+
+bool uring_engine::register_buffer_ring()
+{
+    buffer_ring_size_ = buffer_count_ * sizeof(io_uring_buf);
+    auto ring = mmap(nullptr, buffer_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+
+    if (ring == MAP_FAILED)
+        return false;
+
+    buffer_ring_ = reinterpret_cast<io_uring_buf_ring *>(ring);
+
+    io_uring_buf_reg registration = {};
+    registration.ring_addr = reinterpret_cast<std::uint64_t>(buffer_ring_);
+    registration.ring_entries = buffer_count_;
+    registration.bgid = buffer_group_;
+
+    if (io_uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &registration, 1) < 0)
+    {
+        munmap(buffer_ring_, buffer_ring_size_);
+        buffer_ring_ = nullptr;
+        return false;
+    }
+
+    buffer_ring_tail_ = 0;
+    buffer_ring_verified_ = false;
+
+    for (std::uint16_t i = 0; i < buffer_count_; i++)
+        recycle_buffer(i);
+
+    return true;
+}
+
+void uring_engine::unregister_buffer_ring()
+{
+    if (!buffer_ring_)
+        return;
+
+    io_uring_buf_reg registration = {};
+    registration.bgid = buffer_group_;
+    io_uring_register(ring_fd_, IORING_UNREGISTER_PBUF_RING, &registration, 1);
+
+    munmap(buffer_ring_, buffer_ring_size_);
+    buffer_ring_ = nullptr;
+}
+
+void uring_engine::provide_buffers(std::uint16_t first_id, std::uint16_t count)
+{
+    auto sqe = get_sqe();
+
+    if (!sqe)
+        return;
+
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = count;
+    sqe->addr = reinterpret_cast<std::uint64_t>(buffers_.data() + static_cast<std::size_t>(first_id) * buffer_size_);
+    sqe->len = buffer_size_;
+    sqe->off = first_id;
+    sqe->buf_group = buffer_group_;
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+    sqe->user_data = encode_user_data(op_provide_buffers, 0);
+}
+
+void uring_engine::recycle_buffer(std::uint16_t buffer_id)
+{
+    if (!buffer_ring_)
+    {
+        provide_buffers(buffer_id, 1);
+        return;
+    }
+
+    auto &entry = buffer_ring_->bufs[buffer_ring_tail_ & (buffer_count_ - 1)];
+    entry.addr = reinterpret_cast<std::uint64_t>(buffers_.data() + static_cast<std::size_t>(buffer_id) * buffer_size_);
+    entry.len = buffer_size_;
+    entry.bid = buffer_id;
+
+    buffer_ring_tail_++;
+    __atomic_store_n(&buffer_ring_->tail, buffer_ring_tail_, __ATOMIC_RELEASE);
+}
+
+void uring_engine::release(std::uint64_t id)
+{
+    auto it = streams_.find(id);
+
+    if (it == streams_.end())
+        return;
+
+    auto &s = it->second;
+
+    // shutting down both directions completes the multishot receive so the kernel drops its reference to the socket
+    ::shutdown(s.socket, SHUT_RDWR);
+    closesocket(s.socket);
+
+    total_pending_ -= s.outbound.pending();
+
+    if (s.send_in_flight)
+        retired_sends_[id] = {std::move(s.outbound), std::move(s.send)};
+
+    stream_ids_.erase(s.token);
+    streams_.erase(it);
+
+    apply_total_limit();
+}
+
+bool uring_engine::apply_limits(std::uint64_t id, stream &s)
+{
+    auto pending = s.outbound.pending();
+
+    // a peer that stopped reading must not be able to grow the process without bound
+    if (limits_.max && pending > limits_.max)
+    {
+        failed_.push_back(s.token);
+        release(id);
+
+        return false;
+    }
+
+    if (limits_.high && !s.congested && pending >= limits_.high)
+    {
+        s.congested = true;
+        congestion_.push_back({s.token, true});
+        update_reading(id, s);
+    }
+    else if (s.congested && pending <= limits_.low)
+    {
+        s.congested = false;
+        congestion_.push_back({s.token, false});
+        update_reading(id, s);
+    }
+
+    apply_total_limit();
+
+    return true;
+}
+
+void uring_engine::apply_total_limit()
+{
+    if (!limits_.total)
+        return;
+
+    bool congested = total_congested_ ? total_pending_ > limits_.total / 2 : total_pending_ >= limits_.total;
+
+    if (congested == total_congested_)
+        return;
+
+    total_congested_ = congested;
+
+    // resubmitting a receive can release a stream, so walk a snapshot of the ids
+    limited_.clear();
+
+    for (auto &[id, s] : streams_)
+        limited_.push_back(id);
+
+    for (auto id : limited_)
+    {
+        auto it = streams_.find(id);
+
+        if (it != streams_.end())
+            update_reading(id, it->second);
+    }
+}
+
+void uring_engine::update_reading(std::uint64_t id, stream &s)
+{
+    bool paused = s.congested || s.read_held || total_congested_;
+
+    if (paused == s.reading_paused)
+        return;
+
+    s.reading_paused = paused;
+
+    // a cancel still in flight leaves the receive armed, its completion submits it again if reading resumed meanwhile
+    if (paused && s.receive_armed)
+        submit_cancel_receive(id);
+    else if (!paused && !s.receive_armed)
+        submit_receive(id, s);
+}
+
+void uring_engine::report_failures(io_handler &handler)
+{
+    for (std::size_t i = 0; i < congestion_.size(); i++)
+    {
+        if (stream_ids_.find(congestion_[i].token) != stream_ids_.end())
+            handler.on_congestion(congestion_[i].token, congestion_[i].congested);
+    }
+
+    congestion_.clear();
+
+    while (!failed_.empty())
+    {
+        auto token = failed_.back();
+        failed_.pop_back();
+
+        handler.on_close(token);
+    }
+}
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef URING_ENGINE_H
+#define URING_ENGINE_H
+
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <linux/io_uring.h>
+#include "buffer_pool.hpp"
+#include "outbound_queue.hpp"
+#include "io_handler.hpp"
+
+namespace acc::net
+{
+    // completion based engine: accepts and receives are multishot, receives land in a kernel provided buffer ring,
+    // and every submission queued while handling a batch of completions goes to the kernel in a single io_uring_enter
+    class uring_engine
+    {
+    public:
+        uring_engine() = default;
+        ~uring_engine();
+
+        uring_engine(const uring_engine &) = delete;
+        uring_engine &operator=(const uring_engine &) = delete;
+
+        bool open();
+        void close();
+
+        bool listen(SOCKET listener);
+        bool attach(SOCKET s, std::uint64_t token);
+        bool write(std::uint64_t token, std::vector<std::uint8_t> &&data);
+        bool write(std::uint64_t token, const shared_frame &frame);
+        void shutdown(std::uint64_t token);
+        void abort(std::uint64_t token);
+        bool is_attached(std::uint64_t token);
+
+        // a held stream is not read from until released, on top of any pause caused by its write limits
+        void hold_reading(std::uint64_t token, bool held);
+
+        // lifetime byte counts of a stream's outbound queue, false if the stream is not attached
+        bool get_progress(std::uint64_t token, std::uint64_t &queued, std::uint64_t &sent);
+
+        void run_once(io_handler &handler, int timeout_ms);
+        void wake();
+
+        // everything queued on a stream is handed to the kernel as one sendmsg, submitted once per pass. a window
+        // additionally holds back streams with fewer than min_bytes pending until it expires
+        void set_coalescing(std::chrono::microseconds window, std::size_t min_bytes);
+        void set_write_limits(const write_limits &limits);
+
+    private:
+        enum operation : std::uint8_t
+        {
+            op_none = 0,
+            op_accept,
+            op_receive,
+            op_send,
+            op_wake,
+            op_provide_buffers,
+            op_cancel
+        };
+
+        static constexpr std::size_t max_slices_ = 64;
+
+        // the kernel reads the message header when the submission is consumed, so it lives apart from the stream
+        struct send_message
+        {
+            msghdr message = {};
+            io_slice slices[max_slices_] = {};
+        };
+
+        struct stream
+        {
+            SOCKET socket = INVALID_SOCKET;
+            std::uint64_t token = 0;
+            outbound_queue outbound = {};
+            std::unique_ptr<send_message> send = nullptr;
+            std::chrono::steady_clock::time_point queued_at = {};
+            bool send_in_flight = false, pending = false, closing = false;
+            bool receive_armed = false, congested = false, read_held = false, reading_paused = false;
+            bool ring_receive = false;
+        };
+
+        struct congestion_event
+        {
+            std::uint64_t token = 0;
+            bool congested = false;
+        };
+
+        struct retired_send
+        {
+            outbound_queue outbound = {};
+            std::unique_ptr<send_message> send = nullptr;
+        };
+
+        io_uring_sqe *get_sqe();
+        bool enter(unsigned int min_complete, int timeout_ms);
+
+        void submit_accept();
+        void submit_receive(std::uint64_t id, stream &s);
+        void submit_cancel_receive(std::uint64_t id);
+        void submit_send(std::uint64_t id, stream &s);
+        stream *writable_stream(std::uint64_t token, std::uint64_t &id);
+        void mark_pending(std::uint64_t id, stream &s);
+        int flush_pending();
+        bool apply_limits(std::uint64_t id, stream &s);
+        void apply_total_limit();
+        void update_reading(std::uint64_t id, stream &s);
+        void submit_wake_read();
+
+        void handle_completion(io_handler &handler, const io_uring_cqe &cqe);
+        bool register_buffer_ring();
+        void unregister_buffer_ring();
+        void provide_buffers(std::uint16_t first_id, std::uint16_t count);
+        void recycle_buffer(std::uint16_t buffer_id);
+        void release(std::uint64_t id);
+        void report_failures(io_handler &handler);
+
+        static constexpr unsigned int queue_depth_ = 1024;
+        static constexpr std::uint16_t buffer_count_ = 512;
+        static constexpr std::uint32_t buffer_size_ = 16 * 1024;
+        static constexpr std::uint16_t buffer_group_ = 0;
+
+        int ring_fd_ = -1, wake_fd_ = -1;
+        std::uint64_t wake_value_ = 0;
+
+        void *sq_ring_ = nullptr, *cq_ring_ = nullptr;
+        std::size_t sq_ring_size_ = 0, cq_ring_size_ = 0;
+
+        unsigned int *sq_head_ = nullptr, *sq_tail_ = nullptr, *sq_mask_ = nullptr, *sq_array_ = nullptr;
+        unsigned int *cq_head_ = nullptr, *cq_tail_ = nullptr, *cq_mask_ = nullptr;
+        unsigned int sq_entries_ = 0, sqe_tail_ = 0, submitted_tail_ = 0;
+
+        io_uring_sqe *sqes_ = nullptr;
+        std::size_t sqes_size_ = 0;
+        io_uring_cqe *cqes_ = nullptr;
+
+        io_uring_buf_ring *buffer_ring_ = nullptr;
+        std::size_t buffer_ring_size_ = 0;
+        std::uint16_t buffer_ring_tail_ = 0;
+        bool buffer_ring_verified_ = false;
+        std::vector<std::uint8_t> buffers_ = {};
+
+        SOCKET listener_ = INVALID_SOCKET;
+
+        std::uint64_t next_stream_id_ = 1;
+        std::unordered_map<std::uint64_t, stream> streams_ = {};
+        std::unordered_map<std::uint64_t, std::uint64_t> stream_ids_ = {};
+
+        // outbound data of released streams stays alive until the kernel has completed the send that references it
+        std::unordered_map<std::uint64_t, retired_send> retired_sends_ = {};
+
+        std::vector<std::uint64_t> failed_ = {}, pending_ = {}, still_pending_ = {}, limited_ = {};
+
+        std::chrono::microseconds coalescing_window_ = {};
+        std::size_t coalescing_bytes_ = 0;
+
+        write_limits limits_ = {};
+        std::size_t total_pending_ = 0;
+        bool total_congested_ = false;
+        std::vector<congestion_event> congestion_ = {};
+
+        std::vector<io_uring_cqe> completions_ = {};
+    };
+}
+
+#endif
@@ -0,0 +1,175 @@
+#include "worker_pool.hpp"
+
+using namespace acc::net;
+
+thread_local worker_pool *worker_pool::current_pool_ = nullptr;
+thread_local std::size_t worker_pool::current_index_ = 0;
+
+worker_pool::~worker_pool()
+{
+    stop();
+}
+
+void worker_pool::start(std::size_t count)
+{
+    stop();
+
+    workers_.clear();
+
+    for (std::size_t i = 0; i < count; i++)
+        workers_.push_back(std::make_unique<worker>());
+
+    running_ = true;
+
+    for (std::size_t i = 0; i < count; i++)
+        workers_[i]->thread = std::thread(&worker_pool::run, this, i);
+}
+
+void worker_pool::stop()
+{
+    {
+        std::lock_guard guard(sleep_mtx_);
+
+        if (!running_.exchange(false))
+            return;
+    }
+
+    sleep_cv_.notify_all();
+
+    for (auto &w : workers_)
+    {
+        if (w->thread.joinable())
+            w->thread.join();
+    }
+}
+
+bool worker_pool::is_running()
+{
+    return running_;
+}
+
+void worker_pool::submit(job &&work)
+{
+    // a worker keeps what it submits itself, the job likely touches what it was just working on
+    auto index = current_pool_ == this ? current_index_ : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+
+    {
+        std::lock_guard guard(workers_[index]->mtx);
+        workers_[index]->jobs.push_back(std::move(work));
+    }
+
+    queued_.fetch_add(1, std::memory_order_release);
+
+    // taking the lock orders the increment against a worker that is about to check it and go to sleep
+    {
+        std::lock_guard guard(sleep_mtx_);
+    }
+
+    sleep_cv_.notify_one();
+}
+
+void worker_pool::run(std::size_t index)
+{
+    current_pool_ = this;
+    current_index_ = index;
+
+    job work = {};
+
+    while (true)
+    {
+        if (take(index, work))
+        {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+
+            work();
+            work = nullptr;
+
+            continue;
+        }
+
+        std::unique_lock guard(sleep_mtx_);
+
+        if (!queued_.load(std::memory_order_acquire) && !running_)
+            break;
+
+        sleep_cv_.wait(guard, [this]
+                       { return queued_.load(std::memory_order_acquire) || !running_; });
+    }
+
+    current_pool_ = nullptr;
+}
+
+bool worker_pool::take(std::size_t index, job &work)
+{
+    {
+        auto &own = *workers_[index];
+        std::lock_guard guard(own.mtx);
+
+        if (!own.jobs.empty())
+        {
+            work = std::move(own.jobs.back());
+            own.jobs.pop_back();
+
+            return true;
+        }
+    }
+
+    for (std::size_t i = 1; i < workers_.size(); i++)
+    {
+        auto &victim = *workers_[(index + i) % workers_.size()];
+        std::lock_guard guard(victim.mtx);
+
+        if (!victim.jobs.empty())
+        {
+            work = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void strand::post(job &&work)
+{
+    {
+        std::lock_guard guard(mtx_);
+
+        jobs_.push_back(std::move(work));
+
+        if (scheduled_)
+            return;
+
+        scheduled_ = true;
+    }
+
+    pool_.submit([self = shared_from_this()]
+                 { self->drain(); });
+}
+
+void strand::drain()
+{
+    for (std::size_t i = 0; i < batch_size_; i++)
+    {
+        job work = {};
+
+        {
+            std::lock_guard guard(mtx_);
+
+            if (jobs_.empty())
+            {
+                scheduled_ = false;
+                return;
+            }
+
+            work = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+
+        work();
+    }
+
+    pool_.submit([self = shared_from_this()]
+                 { self->drain(); });
+}
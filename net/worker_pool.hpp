@@ -0,0 +1,85 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace acc::net
+{
+    typedef std::function<void()> job;
+
+    // runs jobs on a fixed set of threads. every worker owns a queue it takes its newest job from, and an idle worker
+    // steals the oldest job of another one before it goes to sleep. jobs submitted from outside the pool are spread
+    // round robin
+    class worker_pool
+    {
+    public:
+        worker_pool() = default;
+        ~worker_pool();
+
+        worker_pool(const worker_pool &) = delete;
+        worker_pool &operator=(const worker_pool &) = delete;
+
+        void start(std::size_t count);
+
+        // runs every job left, including those the remaining jobs submit, before the workers exit
+        void stop();
+
+        bool is_running();
+        void submit(job &&work);
+
+    private:
+        struct worker
+        {
+            std::mutex mtx = {};
+            std::deque<job> jobs = {};
+            std::thread thread = {};
+        };
+
+        void run(std::size_t index);
+        bool take(std::size_t index, job &work);
+
+        static thread_local worker_pool *current_pool_;
+        static thread_local std::size_t current_index_;
+
+        std::vector<std::unique_ptr<worker>> workers_ = {};
+        std::atomic<std::size_t> next_worker_ = 0;
+
+        // counts queued jobs so a worker only sleeps once there is nothing left to steal
+        std::atomic<std::size_t> queued_ = 0;
+        std::atomic_bool running_ = false;
+
+        std::mutex sleep_mtx_ = {};
+        std::condition_variable sleep_cv_ = {};
+    };
+
+    // runs the jobs posted to it one at a time in the order they were posted, on whichever worker is free. a strand
+    // gives up its worker after a batch of jobs so one busy strand cannot starve the others
+    class strand : public std::enable_shared_from_this<strand>
+    {
+    public:
+        explicit strand(worker_pool &pool) : pool_(pool) {}
+
+        void post(job &&work);
+
+    private:
+        void drain();
+
+        static constexpr std::size_t batch_size_ = 32;
+
+        worker_pool &pool_;
+
+        std::mutex mtx_ = {};
+        std::deque<job> jobs_ = {};
+        bool scheduled_ = false;
+    };
+}
+
+#endif
@@ -0,0 +1,255 @@
+#include "compression.hpp"
+
+using namespace acc::packet::detail;
+
+namespace
+{
+    constexpr std::size_t min_match = 4;
+    constexpr std::size_t last_literals = 5;
+    constexpr std::size_t match_search_margin = 12;
+    constexpr std::size_t max_offset = 65535;
+    constexpr std::size_t hash_bits = 12;
+
+    // a block byte never yields more than 255 bytes, a run of 255 continuation bytes being the densest encoding
+    constexpr std::size_t max_inflation = 255;
+
+    std::uint32_t read_u32(const std::uint8_t *p)
+    {
+        std::uint32_t value = 0;
+        memcpy(&value, p, sizeof(value));
+
+        return value;
+    }
+
+    std::uint32_t hash(std::uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - hash_bits);
+    }
+
+    // writes the 255 continuation bytes of a length that did not fit in its token nibble
+    bool write_length(std::uint8_t *&op, const std::uint8_t *end, std::size_t length)
+    {
+        while (length >= 255)
+        {
+            if (op == end)
+                return false;
+
+            *op++ = 255;
+            length -= 255;
+        }
+
+        if (op == end)
+            return false;
+
+        *op++ = static_cast<std::uint8_t>(length);
+        return true;
+    }
+
+    bool read_length(const std::uint8_t *&ip, const std::uint8_t *end, std::size_t &length)
+    {
+        std::uint8_t next = 255;
+
+        while (next == 255)
+        {
+            if (ip == end)
+                return false;
+
+            next = *ip++;
+            length += next;
+        }
+
+        return true;
+    }
+
+    bool write_sequence(std::uint8_t *&op, const std::uint8_t *end, const std::uint8_t *literals, std::size_t literal_length, std::size_t offset, std::size_t match_length)
+    {
+        if (op == end)
+            return false;
+
+        auto token = op++;
+        *token = static_cast<std::uint8_t>(std::min<std::size_t>(literal_length, 15) << 4);
+
+        if (literal_length >= 15 && !write_length(op, end, literal_length - 15))
+            return false;
+
+        if (static_cast<std::size_t>(end - op) < literal_length)
+            return false;
+
+        memcpy(op, literals, literal_length);
+        op += literal_length;
+
+        // the final sequence is literals only
+        if (!match_length)
+            return true;
+
+        if (end - op < 2)
+            return false;
+
+        *op++ = static_cast<std::uint8_t>(offset);
+        *op++ = static_cast<std::uint8_t>(offset >> 8);
+
+        match_length -= min_match;
+        *token |= static_cast<std::uint8_t>(std::min<std::size_t>(match_length, 15));
+
+        return match_length < 15 || write_length(op, end, match_length - 15);
+    }
+}
+
+std::size_t acc::packet::detail::compress_bound(std::size_t length)
+{
+    return length + length / 255 + 16;
+}
+
+std::size_t acc::packet::detail::compress_block(const std::uint8_t *in, std::size_t length, std::uint8_t *out, std::size_t capacity)
+{
+    thread_local std::uint32_t table[1 << hash_bits];
+    memset(table, 0, sizeof(table));
+
+    auto op = out;
+    auto end = out + capacity;
+
+    std::size_t ip = 0, anchor = 0;
+
+    while (length > match_search_margin && ip < length - match_search_margin)
+    {
+        auto sequence = read_u32(in + ip);
+        auto &slot = table[hash(sequence)];
+
+        // slots hold position + 1 so a cleared table reads as empty
+        std::size_t candidate = slot;
+        slot = static_cast<std::uint32_t>(ip + 1);
+
+        if (!candidate || ip - (candidate - 1) > max_offset || read_u32(in + candidate - 1) != sequence)
+        {
+            // skip ahead faster the longer nothing matched, incompressible data costs little
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+
+        auto match = candidate - 1;
+        auto match_length = min_match;
+
+        while (ip + match_length < length - last_literals && in[match + match_length] == in[ip + match_length])
+            match_length++;
+
+        if (!write_sequence(op, end, in + anchor, ip - anchor, ip - match, match_length))
+            return 0;
+
+        ip += match_length;
+        anchor = ip;
+    }
+
+    if (!write_sequence(op, end, in + anchor, length - anchor, 0, 0))
+        return 0;
+
+    return static_cast<std::size_t>(op - out);
+}
+
+bool acc::packet::detail::decompress_block(const std::uint8_t *in, std::size_t in_length, std::uint8_t *out, std::size_t length)
+{
+    auto ip = in;
+    auto in_end = in + in_length;
+
+    std::size_t op = 0;
+
+    while (ip < in_end)
+    {
+        auto token = *ip++;
+        std::size_t literal_length = token >> 4;
+
+        if (literal_length == 15 && !read_length(ip, in_end, literal_length))
+            return false;
+
+        if (literal_length > static_cast<std::size_t>(in_end - ip) || literal_length > length - op)
+            return false;
+
+        memcpy(out + op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        if (ip == in_end)
+            break;
+
+        if (in_end - ip < 2)
+            return false;
+
+        std::size_t offset = ip[0] | (static_cast<std::size_t>(ip[1]) << 8);
+        ip += 2;
+
+        if (!offset || offset > op)
+            return false;
+
+        std::size_t match_length = token & 15;
+
+        if (match_length == 15 && !read_length(ip, in_end, match_length))
+            return false;
+
+        match_length += min_match;
+
+        if (match_length > length - op)
+            return false;
+
+        // overlapping matches repeat the bytes just written, so they are copied forwards one at a time
+        if (offset >= match_length)
+            memcpy(out + op, out + op - offset, match_length);
+        else
+        {
+            for (std::size_t i = 0; i < match_length; i++)
+                out[op + i] = out[op + i - offset];
+        }
+
+        op += match_length;
+    }
+
+    return op == length;
+}
+
+bool acc::packet::detail::compress_frame(const std::uint8_t *frame, std::size_t length, std::vector<std::uint8_t> &out)
+{
+    auto payload_length = length - sizeof(header);
+    auto prefix = sizeof(header) + sizeof(std::uint32_t);
+
+    out.resize(prefix + compress_bound(payload_length));
+
+    auto compressed = compress_block(frame + sizeof(header), payload_length, out.data() + prefix, out.size() - prefix);
+
+    if (!compressed || prefix + compressed >= length)
+        return false;
+
+    out.resize(prefix + compressed);
+
+    header frame_header = {};
+    memcpy(&frame_header, frame, sizeof(header));
+
+    frame_header.flags |= flags::fl_compressed;
+    frame_header.length = static_cast<packet_length>(out.size());
+
+    auto original_length = static_cast<std::uint32_t>(payload_length);
+
+    memcpy(out.data(), &frame_header, sizeof(header));
+    memcpy(out.data() + sizeof(header), &original_length, sizeof(original_length));
+
+    return true;
+}
+
+bool acc::packet::detail::decompress_payload(const std::uint8_t *payload, std::size_t length, std::size_t max_length, std::vector<std::uint8_t> &out)
+{
+    std::uint32_t original_length = 0;
+
+    if (length < sizeof(original_length))
+        return false;
+
+    memcpy(&original_length, payload, sizeof(original_length));
+
+    // checked before anything is allocated, the length is only what the peer claims
+    if (original_length > max_length || original_length > (length - sizeof(original_length)) * max_inflation)
+        return false;
+
+    // a one-off large frame does not keep its memory for the rest of the connection
+    if (out.capacity() > std::max<std::size_t>(original_length, PACKET_BUFFER_SIZE) * 4)
+        std::vector<std::uint8_t>().swap(out);
+
+    out.resize(original_length);
+
+    return decompress_block(payload + sizeof(original_length), length - sizeof(original_length), out.data(), original_length);
+}
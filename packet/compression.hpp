@@ -0,0 +1,31 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "packet_base.hpp"
+
+namespace acc::packet::detail
+{
+    // built-in LZ77 codec with an LZ4 style block format: byte aligned literal runs and matches against the last
+    // 64 KiB, no entropy stage. it trades ratio for speed, string heavy payloads still shrink severalfold
+    std::size_t compress_bound(std::size_t length);
+
+    // returns the compressed size, or 0 if the result would not fit in capacity
+    std::size_t compress_block(const std::uint8_t *in, std::size_t length, std::uint8_t *out, std::size_t capacity);
+
+    // fails on malformed input or if it does not inflate to exactly length bytes
+    bool decompress_block(const std::uint8_t *in, std::size_t in_length, std::uint8_t *out, std::size_t length);
+
+    // a compressed frame carries fl_compressed and a payload of the original payload length followed by the block.
+    // out receives the whole frame, false if compressing would not make it smaller
+    bool compress_frame(const std::uint8_t *frame, std::size_t length, std::vector<std::uint8_t> &out);
+
+    // inflates the payload of a compressed frame, false if it is malformed, inflates past max_length or claims more
+    // than its block can encode
+    bool decompress_payload(const std::uint8_t *payload, std::size_t length, std::size_t max_length, std::vector<std::uint8_t> &out);
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include <concepts>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "schema.hpp"
+
+namespace acc::packet
+{
+    // routes received packets to typed handlers through a table indexed by packet id. a handler is called with the
+    // packet decoded into an instance kept per thread and packet type, so decoding reuses the buffers of the previous
+    // packet. handlers may move out of it but must not keep a reference to it
+    template <typename... Args>
+    class dispatch_table
+    {
+    public:
+        template <schema_packet T, typename F>
+            requires std::invocable<std::decay_t<F> &, Args..., T &>
+        void add(F &&handler)
+        {
+            typedef std::decay_t<F> handler_type;
+
+            auto id = static_cast<packet_id>(T::id);
+
+            if (id >= entries_.size())
+                entries_.resize(static_cast<std::size_t>(id) + 1);
+
+            auto owned = std::shared_ptr<handler_type>(new handler_type(std::forward<F>(handler)));
+
+            entries_[id] = {owned.get(), &invoke<T, handler_type>};
+            handlers_.push_back(std::move(owned));
+        }
+
+        bool contains(packet_id id) const
+        {
+            return id < entries_.size() && entries_[id].invoke;
+        }
+
+        // false if no handler takes id. a packet that fails to decode is not handed on and leaves s failed
+        bool dispatch(packet_id id, detail::serializer &s, Args... args) const
+        {
+            if (!contains(id))
+                return false;
+
+            auto &entry = entries_[id];
+            entry.invoke(entry.handler, s, args...);
+
+            return true;
+        }
+
+    private:
+        template <schema_packet T, typename F>
+        static void invoke(void *handler, detail::serializer &s, Args... args)
+        {
+            thread_local T packet = {};
+
+            if (decode(s, packet))
+                (*static_cast<F *>(handler))(args..., packet);
+        }
+
+        struct entry
+        {
+            void *handler = nullptr;
+            void (*invoke)(void *handler, detail::serializer &s, Args... args) = nullptr;
+        };
+
+        std::vector<entry> entries_ = {};
+        std::vector<std::shared_ptr<void>> handlers_ = {};
+    };
+}
+
+#endif
@@ -0,0 +1,128 @@
+#include "frame_buffer.hpp"
+
+using namespace acc::packet::detail;
+
+frame_buffer::frame_buffer(frame_buffer &&other) noexcept
+{
+    swap(other);
+}
+
+frame_buffer &frame_buffer::operator=(frame_buffer &&other) noexcept
+{
+    frame_buffer moved(std::move(other));
+    swap(moved);
+
+    return *this;
+}
+
+void frame_buffer::reserve(std::size_t capacity)
+{
+    if (capacity > capacity_)
+        reallocate(capacity);
+}
+
+void frame_buffer::append(const std::uint8_t *data, std::size_t length)
+{
+    if (!length)
+        return;
+
+    memcpy(prepare(length), data, length);
+    commit(length);
+}
+
+std::uint8_t *frame_buffer::prepare(std::size_t length)
+{
+    if (capacity_ - write_offset_ < length)
+    {
+        auto unread = write_offset_ - read_offset_;
+
+        if (capacity_ - unread >= length)
+        {
+            memmove(storage_.get(), storage_.get() + read_offset_, unread);
+
+            read_offset_ = 0;
+            write_offset_ = unread;
+        }
+        else
+            reallocate(std::max(capacity_ * 2, unread + length));
+    }
+
+    return storage_.get() + write_offset_;
+}
+
+void frame_buffer::commit(std::size_t length)
+{
+    write_offset_ += length;
+    peak_ = std::max(peak_, write_offset_ - read_offset_);
+}
+
+void frame_buffer::consume(std::size_t length)
+{
+    read_offset_ += length;
+
+    if (read_offset_ >= write_offset_)
+        read_offset_ = write_offset_ = 0;
+}
+
+void frame_buffer::clear()
+{
+    read_offset_ = write_offset_ = 0;
+}
+
+void frame_buffer::swap(frame_buffer &other) noexcept
+{
+    storage_.swap(other.storage_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(read_offset_, other.read_offset_);
+    std::swap(write_offset_, other.write_offset_);
+    std::swap(peak_, other.peak_);
+}
+
+void frame_buffer::trim(std::size_t floor)
+{
+    auto needed = std::max(floor, peak_);
+
+    if (capacity_ > needed * 2)
+        reallocate(std::max(needed, size()));
+
+    peak_ = size();
+}
+
+void frame_buffer::reallocate(std::size_t capacity)
+{
+    auto unread = write_offset_ - read_offset_;
+    auto grown = std::unique_ptr<std::uint8_t[]>(new std::uint8_t[capacity]);
+
+    if (unread)
+        memcpy(grown.get(), storage_.get() + read_offset_, unread);
+
+    storage_ = std::move(grown);
+    capacity_ = capacity;
+    read_offset_ = 0;
+    write_offset_ = unread;
+}
+
+const std::uint8_t *frame_buffer::data() const
+{
+    return storage_.get() + read_offset_;
+}
+
+const std::uint8_t *frame_buffer::tail() const
+{
+    return storage_.get() + write_offset_;
+}
+
+std::size_t frame_buffer::size() const
+{
+    return write_offset_ - read_offset_;
+}
+
+std::size_t frame_buffer::capacity() const
+{
+    return capacity_;
+}
+
+bool frame_buffer::empty() const
+{
+    return read_offset_ == write_offset_;
+}
@@ -0,0 +1,50 @@
+#ifndef FRAME_BUFFER_H
+#define FRAME_BUFFER_H
+
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+
+namespace acc::packet::detail
+{
+    // receive side buffer that frames are parsed from in place. consuming only advances the read offset, the
+    // unread tail is moved to the front when more room is needed, which is at most one partial frame
+    class frame_buffer
+    {
+    public:
+        frame_buffer() = default;
+        frame_buffer(frame_buffer &&other) noexcept;
+        frame_buffer &operator=(frame_buffer &&other) noexcept;
+
+        void reserve(std::size_t capacity);
+        void append(const std::uint8_t *data, std::size_t length);
+
+        // room for at least length bytes past the end, to be written in place and then committed
+        std::uint8_t *prepare(std::size_t length);
+        void commit(std::size_t length);
+
+        void consume(std::size_t length);
+        void clear();
+        void swap(frame_buffer &other) noexcept;
+
+        // gives back the capacity that the traffic since the last trim did not need, so a buffer that once held a
+        // large frame returns to floor after a quiet interval
+        void trim(std::size_t floor);
+
+        const std::uint8_t *data() const;
+        const std::uint8_t *tail() const;
+        std::size_t size() const;
+        std::size_t capacity() const;
+        bool empty() const;
+
+    private:
+        void reallocate(std::size_t capacity);
+
+        // not a vector: growing neither zeroes the new room nor copies the consumed bytes
+        std::unique_ptr<std::uint8_t[]> storage_ = {};
+        std::size_t capacity_ = 0, read_offset_ = 0, write_offset_ = 0, peak_ = 0;
+    };
+}
+
+#endif
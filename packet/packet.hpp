@@ -1,43 +1,35 @@
 #ifndef PACKET_H
 #define PACKET_H
 
-#include "packet_base.hpp"
+#include "schema.hpp"
 
 namespace acc::packet
 {
-    class example_packet : public base_packet
+    class example_packet
     {
     public:
-        example_packet() {}
-
-        example_packet(detail::serializer &s)
-        {
-            deserialize_value(s);
-        }
+        static constexpr packet_id id = ids::id_example;
 
-        virtual void serialize_value(detail::serializer &s)
+        // declared ahead of any member that encodes or decodes, its return type is deduced from the definition
+        auto fields()
         {
-            s.serialize_value(some_short);
-            s.serialize_value(some_array);
-            s.serialize_value(some_string_array);
+            return std::tie(some_short, some_array, some_string_array);
         }
 
-        virtual void deserialize_value(detail::serializer &s)
-        {
-            s.deserialize_value(some_short);
-            s.deserialize_value(some_array);
-            s.deserialize_value(some_string_array);
-        }
+        example_packet() {}
 
-        virtual packet_id get_id()
+        example_packet(detail::serializer &s)
         {
-            return ids::id_example;
+            decode(s, *this);
         }
 
         std::uint16_t some_short = 0;
         std::vector<std::uint8_t> some_array = {};
         std::vector<std::string> some_string_array = {};
     };
+
+    // every schema packet belongs in this list, so that two packets sharing an id fail to compile
+    typedef packet_set<example_packet> packets;
 }
 
-#endif
\ No newline at end of file
+#endif
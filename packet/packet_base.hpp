@@ -2,8 +2,10 @@
 #define PACKET_BASE_H
 
 #include "serializer.hpp"
+#include "frame_buffer.hpp"
 
 #define PACKET_BUFFER_SIZE 4096
+#define PACKET_MAX_FRAME_SIZE (16 * 1024 * 1024)
 #define PACKET_MAGIC 'FI00'
 
 #pragma pack(push, 1)
@@ -26,7 +28,18 @@ namespace acc::packet
         fl_handshake_cl = (1 << 0),
         fl_handshake_sv = (1 << 1),
         fl_heartbeat = (1 << 2),
-        fl_disconnect = (1 << 3)
+        fl_disconnect = (1 << 3),
+        fl_compressed = (1 << 4),
+        fl_compact = (1 << 5),
+        fl_request = (1 << 6),
+        fl_response = (1 << 7)
+    };
+
+    // a client may append a feature mask to its handshake, the server answers with the subset it accepts
+    enum features : std::uint32_t
+    {
+        ft_none = 0,
+        ft_compression = (1 << 0)
     };
 
     struct header
@@ -41,12 +54,20 @@ namespace acc::packet
     typedef decltype(header::flags) packet_flags;
     typedef decltype(header::length) packet_length;
 
+    // requests and responses carry the call they belong to in front of their payload, so any number can be in flight
+    typedef std::uint32_t call_id;
+
     class base_packet
     {
     public:
         virtual void serialize_value(detail::serializer &s) = 0;
         virtual void deserialize_value(detail::serializer &s) = 0;
         virtual packet_id get_id() = 0;
+
+        virtual encoding get_encoding()
+        {
+            return enc_fixed;
+        }
     };
 }
 
@@ -0,0 +1,433 @@
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include <array>
+#include <tuple>
+#include <concepts>
+#include <type_traits>
+#include "packet_base.hpp"
+
+namespace acc::packet
+{
+    // a schema packet is a plain struct with a static id and a fields() member listing its members in wire order:
+    //
+    //     struct position_packet
+    //     {
+    //         static constexpr packet_id id = 10;
+    //
+    //         float x = 0, y = 0;
+    //
+    //         auto fields() { return std::tie(x, y); }
+    //     };
+    //
+    // encoding and decoding are generated from fields() without virtual calls, and produce the same bytes as a
+    // base_packet serializing the same members in the same order
+    template <typename T>
+    concept schema_packet = requires(T &p) {
+        { T::id } -> std::convertible_to<packet_id>;
+        p.fields();
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        struct field_traits;
+
+        template <typename T>
+            requires std::is_arithmetic_v<T>
+        struct field_traits<T>
+        {
+            static constexpr bool fixed = true;
+            static constexpr std::size_t fixed_size = sizeof(T);
+
+            static std::size_t encoded_size(const T &) { return sizeof(T); }
+
+            static std::uint8_t *encode(std::uint8_t *out, const T &value)
+            {
+                memcpy(out, &value, sizeof(T));
+                return out + sizeof(T);
+            }
+
+            static std::size_t compact_size(const T &value) { return detail::compact_size(value); }
+
+            static std::uint8_t *encode_compact(std::uint8_t *out, const T &value) { return write_compact(out, value); }
+        };
+
+        template <typename T>
+            requires std::is_arithmetic_v<T>
+        struct field_traits<std::vector<T>>
+        {
+            static constexpr bool fixed = false;
+            static constexpr std::size_t fixed_size = 0;
+
+            static std::size_t encoded_size(const std::vector<T> &value) { return sizeof(std::uint32_t) + value.size() * sizeof(T); }
+
+            static std::uint8_t *encode(std::uint8_t *out, const std::vector<T> &value)
+            {
+                out = field_traits<std::uint32_t>::encode(out, static_cast<std::uint32_t>(value.size()));
+
+                if (value.empty())
+                    return out;
+
+                memcpy(out, value.data(), value.size() * sizeof(T));
+                return out + value.size() * sizeof(T);
+            }
+
+            static std::size_t compact_size(const std::vector<T> &value) { return varint_size(value.size()) + value.size() * sizeof(T); }
+
+            static std::uint8_t *encode_compact(std::uint8_t *out, const std::vector<T> &value)
+            {
+                out = write_varint(out, value.size());
+                return write_little_endian(out, value.data(), value.size());
+            }
+        };
+
+        template <>
+        struct field_traits<std::string>
+        {
+            static constexpr bool fixed = false;
+            static constexpr std::size_t fixed_size = 0;
+
+            static std::size_t encoded_size(const std::string &value) { return sizeof(std::uint32_t) + value.size(); }
+
+            static std::uint8_t *encode(std::uint8_t *out, const std::string &value)
+            {
+                out = field_traits<std::uint32_t>::encode(out, static_cast<std::uint32_t>(value.size()));
+
+                memcpy(out, value.data(), value.size());
+                return out + value.size();
+            }
+
+            static std::size_t compact_size(const std::string &value) { return varint_size(value.size()) + value.size(); }
+
+            static std::uint8_t *encode_compact(std::uint8_t *out, const std::string &value)
+            {
+                out = write_varint(out, value.size());
+
+                memcpy(out, value.data(), value.size());
+                return out + value.size();
+            }
+        };
+
+        template <>
+        struct field_traits<std::vector<std::string>>
+        {
+            static constexpr bool fixed = false;
+            static constexpr std::size_t fixed_size = 0;
+
+            static std::size_t encoded_size(const std::vector<std::string> &value)
+            {
+                std::size_t size = sizeof(std::uint32_t);
+
+                for (auto &s : value)
+                    size += field_traits<std::string>::encoded_size(s);
+
+                return size;
+            }
+
+            static std::uint8_t *encode(std::uint8_t *out, const std::vector<std::string> &value)
+            {
+                out = field_traits<std::uint32_t>::encode(out, static_cast<std::uint32_t>(value.size()));
+
+                for (auto &s : value)
+                    out = field_traits<std::string>::encode(out, s);
+
+                return out;
+            }
+
+            static std::size_t compact_size(const std::vector<std::string> &value)
+            {
+                std::size_t size = varint_size(value.size());
+
+                for (auto &s : value)
+                    size += field_traits<std::string>::compact_size(s);
+
+                return size;
+            }
+
+            // the lengths come first as one table, followed by all of the characters
+            static std::uint8_t *encode_compact(std::uint8_t *out, const std::vector<std::string> &value)
+            {
+                out = write_varint(out, value.size());
+
+                for (auto &s : value)
+                    out = write_varint(out, s.size());
+
+                for (auto &s : value)
+                {
+                    memcpy(out, s.data(), s.size());
+                    out += s.size();
+                }
+
+                return out;
+            }
+        };
+
+        template <typename T>
+        struct field_traits<packed_vector<T>>
+        {
+            static constexpr bool fixed = false;
+            static constexpr std::size_t fixed_size = 0;
+
+            static std::size_t encoded_size(const packed_vector<T> &value) { return sizeof(std::uint32_t) + payload_size(value); }
+
+            static std::uint8_t *encode(std::uint8_t *out, const packed_vector<T> &value)
+            {
+                out = field_traits<std::uint32_t>::encode(out, static_cast<std::uint32_t>(value.values.size()));
+                return encode_payload(out, value);
+            }
+
+            static std::size_t compact_size(const packed_vector<T> &value) { return varint_size(value.values.size()) + payload_size(value); }
+
+            static std::uint8_t *encode_compact(std::uint8_t *out, const packed_vector<T> &value)
+            {
+                out = write_varint(out, value.values.size());
+                return encode_payload(out, value);
+            }
+
+            static std::size_t payload_size(const packed_vector<T> &value)
+            {
+                return packed_size(value.values.size(), plan_packed(data(value), value.values.size(), std::is_signed_v<T>));
+            }
+
+            static std::uint8_t *encode_payload(std::uint8_t *out, const packed_vector<T> &value)
+            {
+                auto plan = plan_packed(data(value), value.values.size(), std::is_signed_v<T>);
+                return encode_packed(data(value), value.values.size(), std::is_signed_v<T>, plan, out);
+            }
+
+            static const std::uint32_t *data(const packed_vector<T> &value) { return reinterpret_cast<const std::uint32_t *>(value.values.data()); }
+        };
+
+        template <std::size_t Bits>
+        struct field_traits<quantized_vector<Bits>>
+        {
+            static constexpr bool fixed = false;
+            static constexpr std::size_t fixed_size = 0;
+
+            static std::size_t encoded_size(const quantized_vector<Bits> &value) { return sizeof(std::uint32_t) + quantized_size(value.values.size(), Bits); }
+
+            static std::uint8_t *encode(std::uint8_t *out, const quantized_vector<Bits> &value)
+            {
+                out = field_traits<std::uint32_t>::encode(out, static_cast<std::uint32_t>(value.values.size()));
+                return encode_quantized(value.values.data(), value.values.size(), Bits, out);
+            }
+
+            static std::size_t compact_size(const quantized_vector<Bits> &value) { return varint_size(value.values.size()) + quantized_size(value.values.size(), Bits); }
+
+            static std::uint8_t *encode_compact(std::uint8_t *out, const quantized_vector<Bits> &value)
+            {
+                out = write_varint(out, value.values.size());
+                return encode_quantized(value.values.data(), value.values.size(), Bits, out);
+            }
+        };
+
+        template <typename T>
+        using fields_t = decltype(std::declval<T &>().fields());
+
+        template <typename Tuple>
+        struct field_layout;
+
+        // leading fixed size fields form a prefix whose size and offsets are known at compile time, it is written and
+        // bounds-checked as one block
+        template <typename... F>
+        struct field_layout<std::tuple<F...>>
+        {
+            static constexpr std::array<bool, sizeof...(F)> fixed = {field_traits<std::remove_cvref_t<F>>::fixed...};
+            static constexpr std::array<std::size_t, sizeof...(F)> sizes = {field_traits<std::remove_cvref_t<F>>::fixed_size...};
+
+            static constexpr std::size_t prefix_count = []
+            {
+                std::size_t count = 0;
+
+                while (count < fixed.size() && fixed[count])
+                    count++;
+
+                return count;
+            }();
+
+            static constexpr std::array<std::size_t, sizeof...(F)> offsets = []
+            {
+                std::array<std::size_t, sizeof...(F)> result = {};
+
+                for (std::size_t i = 1; i < prefix_count; i++)
+                    result[i] = result[i - 1] + sizes[i - 1];
+
+                return result;
+            }();
+
+            static constexpr std::size_t prefix_size = prefix_count ? offsets[prefix_count - 1] + sizes[prefix_count - 1] : 0;
+            static constexpr bool all_fixed = prefix_count == sizeof...(F);
+        };
+
+        template <typename T>
+        using layout_of = field_layout<fields_t<T>>;
+
+        template <std::size_t N>
+        consteval bool ids_unique(std::array<packet_id, N> ids)
+        {
+            for (std::size_t i = 0; i < N; i++)
+            {
+                for (std::size_t j = i + 1; j < N; j++)
+                {
+                    if (ids[i] == ids[j])
+                        return false;
+                }
+            }
+
+            return true;
+        }
+
+        template <typename Fields, std::size_t I>
+        using field_t = std::remove_cvref_t<std::tuple_element_t<I, Fields>>;
+
+        template <typename Fields, std::size_t... I>
+        std::size_t dynamic_size(const Fields &fields, std::index_sequence<I...>)
+        {
+            using layout = field_layout<Fields>;
+
+            std::size_t size = 0;
+
+            ([&]
+             {
+                if constexpr (I >= layout::prefix_count)
+                    size += field_traits<field_t<Fields, I>>::encoded_size(std::get<I>(fields)); }(),
+             ...);
+
+            return size;
+        }
+
+        template <typename Fields, std::size_t... I>
+        void encode_fields(const Fields &fields, std::uint8_t *out, std::index_sequence<I...>)
+        {
+            using layout = field_layout<Fields>;
+
+            auto cursor = out + layout::prefix_size;
+
+            ([&]
+             {
+                if constexpr (I < layout::prefix_count)
+                    field_traits<field_t<Fields, I>>::encode(out + layout::offsets[I], std::get<I>(fields));
+                else
+                    cursor = field_traits<field_t<Fields, I>>::encode(cursor, std::get<I>(fields)); }(),
+             ...);
+        }
+
+        template <typename Fields, std::size_t... I>
+        std::size_t compact_fields_size(const Fields &fields, std::index_sequence<I...>)
+        {
+            return (std::size_t(0) + ... + field_traits<field_t<Fields, I>>::compact_size(std::get<I>(fields)));
+        }
+
+        template <typename Fields, std::size_t... I>
+        void encode_compact_fields(const Fields &fields, std::uint8_t *out, std::index_sequence<I...>)
+        {
+            ((out = field_traits<field_t<Fields, I>>::encode_compact(out, std::get<I>(fields))), ...);
+        }
+
+        template <typename Fields, std::size_t... I>
+        void decode_fields(serializer &s, Fields &fields, std::index_sequence<I...>)
+        {
+            using layout = field_layout<Fields>;
+
+            // compact fields have no fixed offsets, every one is read in turn
+            if (s.get_encoding() == enc_compact)
+            {
+                (s.deserialize_value(std::get<I>(fields)), ...);
+                return;
+            }
+
+            auto prefix = s.deserialize_bytes(layout::prefix_size);
+
+            ([&]
+             {
+                if constexpr (I < layout::prefix_count)
+                {
+                    if (prefix)
+                        memcpy(&std::get<I>(fields), prefix + layout::offsets[I], layout::sizes[I]);
+                }
+                else
+                    s.deserialize_value(std::get<I>(fields)); }(),
+             ...);
+        }
+    }
+
+    // a packet opts into the compact encoding by declaring static constexpr encoding wire_encoding = enc_compact
+    template <schema_packet T>
+    constexpr encoding encoding_of()
+    {
+        if constexpr (requires { T::wire_encoding; })
+            return T::wire_encoding;
+        else
+            return enc_fixed;
+    }
+
+    // header flags announcing the packet's encoding to the receiver
+    template <schema_packet T>
+    constexpr packet_flags encoding_flags()
+    {
+        return encoding_of<T>() == enc_compact ? flags::fl_compact : flags::fl_none;
+    }
+
+    // number of payload bytes the packet encodes to, constant for fixed encoded packets made of arithmetic fields only
+    template <schema_packet T>
+    std::size_t encoded_size(const T &packet)
+    {
+        using layout = detail::layout_of<T>;
+
+        if constexpr (encoding_of<T>() == enc_compact)
+        {
+            auto fields = const_cast<T &>(packet).fields();
+            return detail::compact_fields_size(fields, std::make_index_sequence<std::tuple_size_v<decltype(fields)>>{});
+        }
+        else if constexpr (layout::all_fixed)
+            return layout::prefix_size;
+        else
+        {
+            auto fields = const_cast<T &>(packet).fields();
+            return layout::prefix_size + detail::dynamic_size(fields, std::make_index_sequence<std::tuple_size_v<decltype(fields)>>{});
+        }
+    }
+
+    // writes the payload to out, which must hold encoded_size(packet) bytes
+    template <schema_packet T>
+    void encode(const T &packet, std::uint8_t *out)
+    {
+        static_assert(T::id > ids::num_preset_ids, "packet id collides with a preset id");
+
+        auto fields = const_cast<T &>(packet).fields();
+
+        if constexpr (encoding_of<T>() == enc_compact)
+            detail::encode_compact_fields(fields, out, std::make_index_sequence<std::tuple_size_v<decltype(fields)>>{});
+        else
+            detail::encode_fields(fields, out, std::make_index_sequence<std::tuple_size_v<decltype(fields)>>{});
+    }
+
+    // reads the packet from s in whichever encoding s was set to, returns false if the payload was malformed
+    template <schema_packet T>
+    bool decode(detail::serializer &s, T &packet)
+    {
+        auto fields = packet.fields();
+        detail::decode_fields(s, fields, std::make_index_sequence<std::tuple_size_v<decltype(fields)>>{});
+
+        return !s.has_failed();
+    }
+
+    template <schema_packet T>
+    T decode(detail::serializer &s)
+    {
+        T packet = {};
+        decode(s, packet);
+
+        return packet;
+    }
+
+    // lists the packets an application uses and rejects duplicate ids at compile time
+    template <schema_packet... Packets>
+    struct packet_set
+    {
+        static_assert(detail::ids_unique(std::array<packet_id, sizeof...(Packets)>{static_cast<packet_id>(Packets::id)...}), "packet ids must be unique");
+    };
+}
+
+#endif
@@ -4,32 +4,84 @@ using namespace acc::packet::detail;
 
 void serializer::serialize_value(const std::string &value)
 {
-    write_to_buffer<std::uint32_t>(value.length());
+    write_count(value.length());
     serialized_buffer_.insert(serialized_buffer_.end(), value.begin(), value.end());
 }
 
 void serializer::serialize_value(const std::vector<std::string> &value)
 {
-    write_to_buffer<std::uint32_t>(value.size());
+    write_count(value.size());
+
+    if (encoding_ == enc_fixed)
+    {
+        for (auto &s : value)
+            serialize_value(s);
+
+        return;
+    }
+
+    // compact string arrays are a table of lengths followed by all of the characters as one blob
+    for (auto &s : value)
+        write_count(s.length());
 
     for (auto &s : value)
-        serialize_value(s);
+        serialized_buffer_.insert(serialized_buffer_.end(), s.begin(), s.end());
 }
 
 void serializer::deserialize_value(std::string &out_value)
 {
-    auto length = read_from_buffer<std::uint32_t>();
-    out_value.resize(length);
-    memcpy(out_value.data(), serialized_buffer_.data() + deserialized_bytes_, length);
+    auto length = read_element_count(1);
+    out_value.assign(reinterpret_cast<const char *>(read_buffer_.data() + deserialized_bytes_), length);
     deserialized_bytes_ += length;
 }
 
+void serializer::deserialize_view(std::string_view &out_value)
+{
+    auto length = read_element_count(1);
+    out_value = std::string_view(reinterpret_cast<const char *>(read_buffer_.data() + deserialized_bytes_), length);
+    deserialized_bytes_ += length;
+}
+
+const std::uint8_t *serializer::deserialize_bytes(std::uint64_t length)
+{
+    if (!can_read(length))
+        return nullptr;
+
+    auto data = read_buffer_.data() + deserialized_bytes_;
+    deserialized_bytes_ += length;
+
+    return data;
+}
+
 void serializer::deserialize_value(std::vector<std::string> &out_value)
 {
-    auto num_strings = read_from_buffer<std::uint32_t>();
+    if (encoding_ == enc_compact)
+    {
+        std::uint64_t table = 0, blob = 0;
+        auto num_strings = read_string_table(table, blob);
+
+        out_value.resize(num_strings);
+
+        auto lengths = read_buffer_.data() + table;
+        auto characters = reinterpret_cast<const char *>(read_buffer_.data() + blob);
+
+        for (std::uint32_t i = 0; i < num_strings; i++)
+        {
+            std::uint64_t length = 0;
+            lengths = read_varint(lengths, read_buffer_.data() + blob, length);
+
+            out_value[i].assign(characters, length);
+            characters += length;
+        }
+
+        return;
+    }
+
+    // every string carries at least its length prefix, which bounds the count before anything is allocated
+    auto num_strings = read_element_count(sizeof(std::uint32_t));
 
     out_value.resize(num_strings);
-    
+
     for (std::uint32_t i = 0; i < num_strings; i++)
     {
         std::string deserialized = "";
@@ -38,6 +90,38 @@ void serializer::deserialize_value(std::vector<std::string> &out_value)
     }
 }
 
+void serializer::deserialize_view(std::vector<std::string_view> &out_value)
+{
+    if (encoding_ == enc_compact)
+    {
+        std::uint64_t table = 0, blob = 0;
+        auto num_strings = read_string_table(table, blob);
+
+        out_value.resize(num_strings);
+
+        auto lengths = read_buffer_.data() + table;
+        auto characters = reinterpret_cast<const char *>(read_buffer_.data() + blob);
+
+        for (std::uint32_t i = 0; i < num_strings; i++)
+        {
+            std::uint64_t length = 0;
+            lengths = read_varint(lengths, read_buffer_.data() + blob, length);
+
+            out_value[i] = std::string_view(characters, length);
+            characters += length;
+        }
+
+        return;
+    }
+
+    auto num_strings = read_element_count(sizeof(std::uint32_t));
+
+    out_value.resize(num_strings);
+
+    for (std::uint32_t i = 0; i < num_strings; i++)
+        deserialize_view(out_value[i]);
+}
+
 std::uint8_t *serializer::get_serialized_data()
 {
     return serialized_buffer_.data();
@@ -48,14 +132,117 @@ std::uint32_t serializer::get_serialized_data_length()
     return serialized_buffer_.size();
 }
 
+bool serializer::has_failed()
+{
+    return failed_;
+}
+
+void serializer::set_max_elements(std::uint32_t max_elements)
+{
+    max_elements_ = max_elements;
+}
+
+void serializer::set_encoding(encoding value)
+{
+    encoding_ = value;
+}
+
+acc::packet::encoding serializer::get_encoding()
+{
+    return encoding_;
+}
+
+void serializer::begin_frame(std::vector<std::uint8_t> &&buffer, std::size_t header_size)
+{
+    reset();
+
+    serialized_buffer_ = std::move(buffer);
+    serialized_buffer_.resize(header_size);
+}
+
+std::vector<std::uint8_t> serializer::take_frame()
+{
+    auto frame = std::move(serialized_buffer_);
+    serialized_buffer_.clear();
+
+    return frame;
+}
+
 void serializer::reset()
 {
+    failed_ = false;
     deserialized_bytes_ = 0;
     serialized_buffer_.clear();
+    read_buffer_ = {};
+    view_copies_.clear();
 }
 
-void serializer::assign_buffer(std::uint8_t *const data, std::uint32_t length)
+void serializer::assign_buffer(const std::uint8_t *const data, std::uint32_t length)
 {
     reset();
     serialized_buffer_.insert(serialized_buffer_.begin(), data, data + length);
-}
\ No newline at end of file
+    read_buffer_ = serialized_buffer_;
+}
+
+void serializer::assign_view(std::span<const std::uint8_t> data)
+{
+    reset();
+    read_buffer_ = data;
+}
+void serializer::write_count(std::size_t count)
+{
+    if (encoding_ == enc_compact)
+        write_compact_value<std::uint32_t>(count);
+    else
+        write_to_buffer<std::uint32_t>(count);
+}
+
+std::uint32_t serializer::read_element_count(std::size_t element_size)
+{
+    auto num_items = encoding_ == enc_compact ? read_compact_value<std::uint32_t>() : read_from_buffer<std::uint32_t>();
+
+    if (num_items > max_elements_)
+        failed_ = true;
+
+    if (!can_read(static_cast<std::uint64_t>(num_items) * element_size))
+        return 0;
+
+    return num_items;
+}
+
+std::uint32_t serializer::read_string_table(std::uint64_t &table, std::uint64_t &blob)
+{
+    // every length takes at least a byte, which bounds the count before the table is walked
+    auto num_strings = read_element_count(1);
+
+    table = deserialized_bytes_;
+
+    std::uint64_t total = 0;
+    auto lengths = read_buffer_.data() + deserialized_bytes_;
+    auto end = read_buffer_.data() + read_buffer_.size();
+
+    for (std::uint32_t i = 0; i < num_strings; i++)
+    {
+        std::uint64_t length = 0;
+        lengths = read_varint(lengths, end, length);
+
+        if (!lengths || length > max_elements_)
+        {
+            failed_ = true;
+            return 0;
+        }
+
+        total += length;
+    }
+
+    deserialized_bytes_ = static_cast<std::uint32_t>(lengths - read_buffer_.data());
+    blob = deserialized_bytes_;
+
+    // the whole blob is bounds-checked once, the strings are then cut from it without further checks
+    if (!can_read(total))
+        return 0;
+
+    deserialized_bytes_ += static_cast<std::uint32_t>(total);
+
+    return num_strings;
+}
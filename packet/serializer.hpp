@@ -2,8 +2,13 @@
 #define SERIALIZER_H
 
 #include <vector>
+#include <span>
 #include <string>
+#include <string_view>
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include "vector_codec.hpp"
 
 #define ONLY_ARITHMETIC_TYPE typename std::enable_if<std::is_arithmetic<T>::value>::type * = nullptr
 
@@ -15,18 +20,30 @@ namespace acc::packet::detail
         template <typename T, ONLY_ARITHMETIC_TYPE>
         void serialize_value(T value)
         {
-            write_to_buffer(value);
+            if (encoding_ == enc_compact)
+                write_compact_value(value);
+            else
+                write_to_buffer(value);
         }
 
         template <typename T, ONLY_ARITHMETIC_TYPE>
         void serialize_value(std::vector<T> &value)
         {
-            write_to_buffer<std::uint32_t>(value.size());
+            write_count(value.size());
 
-            serialized_buffer_.insert(
-                serialized_buffer_.end(),
-                reinterpret_cast<std::uint8_t *>(value.data()),
-                reinterpret_cast<std::uint8_t *>(value.data()) + value.size() * sizeof(T));
+            if (encoding_ == enc_fixed || std::endian::native == std::endian::little)
+            {
+                serialized_buffer_.insert(
+                    serialized_buffer_.end(),
+                    reinterpret_cast<std::uint8_t *>(value.data()),
+                    reinterpret_cast<std::uint8_t *>(value.data()) + value.size() * sizeof(T));
+                return;
+            }
+
+            auto offset = serialized_buffer_.size();
+            serialized_buffer_.resize(offset + value.size() * sizeof(T));
+
+            write_little_endian(serialized_buffer_.data() + offset, value.data(), value.size());
         }
 
         void serialize_value(const std::string &value);
@@ -35,28 +52,160 @@ namespace acc::packet::detail
         template <typename T, ONLY_ARITHMETIC_TYPE>
         void deserialize_value(T &value)
         {
-            value = read_from_buffer<T>();
+            if (encoding_ == enc_compact)
+                value = read_compact_value<T>();
+            else
+                value = read_from_buffer<T>();
         }
 
         template <typename T, ONLY_ARITHMETIC_TYPE>
         void deserialize_value(std::vector<T> &out_value)
         {
-            auto num_items = read_from_buffer<std::uint32_t>();
+            auto num_items = read_element_count(sizeof(T));
 
             out_value.resize(num_items);
-            memcpy(out_value.data(), serialized_buffer_.data() + deserialized_bytes_, num_items * sizeof(T));
+
+            if (num_items == 0)
+                return;
+
+            memcpy(out_value.data(), read_buffer_.data() + deserialized_bytes_, num_items * sizeof(T));
 
             deserialized_bytes_ += num_items * sizeof(T);
+
+            if (encoding_ == enc_compact)
+                swap_little_endian(out_value.data(), num_items);
         }
 
         void deserialize_value(std::string &out_value);
         void deserialize_value(std::vector<std::string> &out_value);
 
+        template <typename T>
+        void serialize_value(const packed_vector<T> &value)
+        {
+            auto values = reinterpret_cast<const std::uint32_t *>(value.values.data());
+            auto plan = plan_packed(values, value.values.size(), std::is_signed_v<T>);
+
+            write_count(value.values.size());
+
+            auto offset = serialized_buffer_.size();
+            serialized_buffer_.resize(offset + packed_size(value.values.size(), plan));
+
+            encode_packed(values, value.values.size(), std::is_signed_v<T>, plan, serialized_buffer_.data() + offset);
+        }
+
+        template <std::size_t Bits>
+        void serialize_value(const quantized_vector<Bits> &value)
+        {
+            write_count(value.values.size());
+
+            auto offset = serialized_buffer_.size();
+            serialized_buffer_.resize(offset + quantized_size(value.values.size(), Bits));
+
+            encode_quantized(value.values.data(), value.values.size(), Bits, serialized_buffer_.data() + offset);
+        }
+
+        template <typename T>
+        void deserialize_value(packed_vector<T> &out_value)
+        {
+            out_value.values.clear();
+
+            // every value takes at least a bit, so the packed bytes bound the count before anything is allocated
+            auto num_items = read_element_count(0);
+
+            if (!num_items)
+                return;
+
+            packed_plan plan = {};
+            auto mode = deserialize_bytes(1);
+
+            if (!mode || !decode_mode(*mode, plan))
+            {
+                failed_ = true;
+                return;
+            }
+
+            auto packed = deserialize_bytes(packed_bytes(num_items, plan.bits));
+
+            if (!packed)
+                return;
+
+            out_value.values.resize(num_items);
+            decode_packed(packed, num_items, std::is_signed_v<T>, plan, reinterpret_cast<std::uint32_t *>(out_value.values.data()));
+        }
+
+        template <std::size_t Bits>
+        void deserialize_value(quantized_vector<Bits> &out_value)
+        {
+            out_value.values.clear();
+
+            auto num_items = read_element_count(0);
+
+            if (!num_items)
+                return;
+
+            auto quantized = deserialize_bytes(quantized_size(num_items, Bits));
+
+            if (!quantized)
+                return;
+
+            out_value.values.resize(num_items);
+            decode_quantized(quantized, num_items, Bits, out_value.values.data());
+        }
+
+        // views point into the assigned buffer and are only valid for as long as it is, which for received packets is
+        // the duration of the callback. an array that is not aligned for T there is copied into storage of the
+        // serializer that lives just as long
+        template <typename T, ONLY_ARITHMETIC_TYPE>
+        void deserialize_view(std::span<const T> &out_value)
+        {
+            // compact arrays are little-endian and cannot be viewed in place on other hosts
+            if (std::endian::native != std::endian::little && sizeof(T) > 1 && encoding_ == enc_compact)
+            {
+                failed_ = true;
+                out_value = {};
+                return;
+            }
+
+            auto num_items = read_element_count(sizeof(T));
+            auto data = read_buffer_.data() + deserialized_bytes_;
+
+            if (num_items && reinterpret_cast<std::uintptr_t>(data) % alignof(T))
+            {
+                // new[] aligns for any arithmetic type
+                view_copies_.push_back(std::make_unique<std::uint8_t[]>(num_items * sizeof(T)));
+                data = static_cast<const std::uint8_t *>(memcpy(view_copies_.back().get(), data, num_items * sizeof(T)));
+            }
+
+            out_value = std::span<const T>(reinterpret_cast<const T *>(data), num_items);
+
+            deserialized_bytes_ += num_items * sizeof(T);
+        }
+
+        void deserialize_view(std::string_view &out_value);
+        void deserialize_view(std::vector<std::string_view> &out_value);
+
+        // returns nullptr and fails if fewer than length bytes remain
+        const std::uint8_t *deserialize_bytes(std::uint64_t length);
+
         std::uint8_t *get_serialized_data();
         std::uint32_t get_serialized_data_length();
 
+        // reads past the end of the buffer or over the element limit yield empty values and mark the serializer as failed
+        bool has_failed();
+        void set_max_elements(std::uint32_t max_elements);
+
+        // applies to everything serialized or deserialized afterwards, received packets select it from their header
+        void set_encoding(encoding value);
+        encoding get_encoding();
+
+        // serializes straight into buffer after header_size bytes left free for the frame header, the finished frame is
+        // handed back by take_frame
+        void begin_frame(std::vector<std::uint8_t> &&buffer, std::size_t header_size);
+        std::vector<std::uint8_t> take_frame();
+
         void reset();
-        void assign_buffer(std::uint8_t *const data, std::uint32_t length);
+        void assign_buffer(const std::uint8_t *const data, std::uint32_t length);
+        void assign_view(std::span<const std::uint8_t> data);
 
     private:
         template <typename T, ONLY_ARITHMETIC_TYPE>
@@ -68,17 +217,73 @@ namespace acc::packet::detail
                 reinterpret_cast<std::uint8_t *>(&value) + sizeof(T));
         }
 
+        template <typename T, ONLY_ARITHMETIC_TYPE>
+        void write_compact_value(T value)
+        {
+            std::uint8_t bytes[max_varint_size] = {};
+            auto end = write_compact(bytes, value);
+
+            serialized_buffer_.insert(serialized_buffer_.end(), bytes, end);
+        }
+
+        template <typename T, ONLY_ARITHMETIC_TYPE>
+        T read_compact_value()
+        {
+            T value = {};
+
+            if (failed_)
+                return value;
+
+            auto begin = read_buffer_.data() + deserialized_bytes_;
+            auto end = read_compact(begin, read_buffer_.data() + read_buffer_.size(), value);
+
+            if (!end)
+            {
+                failed_ = true;
+                return T{};
+            }
+
+            deserialized_bytes_ += end - begin;
+
+            return value;
+        }
+
         template <typename T, ONLY_ARITHMETIC_TYPE>
         T read_from_buffer()
         {
-            auto value = *reinterpret_cast<T *>(serialized_buffer_.data() + deserialized_bytes_);
+            T value = {};
+
+            if (!can_read(sizeof(T)))
+                return value;
+
+            memcpy(&value, read_buffer_.data() + deserialized_bytes_, sizeof(T));
             deserialized_bytes_ += sizeof(T);
 
             return value;
         }
 
+        bool can_read(std::uint64_t length)
+        {
+            if (failed_ || length > read_buffer_.size() - deserialized_bytes_)
+            {
+                failed_ = true;
+                return false;
+            }
+
+            return true;
+        }
+
+        void write_count(std::size_t count);
+        std::uint32_t read_element_count(std::size_t element_size);
+        std::uint32_t read_string_table(std::uint64_t &table, std::uint64_t &blob);
+
+        bool failed_ = false;
+        encoding encoding_ = enc_fixed;
+        std::uint32_t max_elements_ = UINT32_MAX;
         std::uint32_t deserialized_bytes_ = 0;
         std::vector<std::uint8_t> serialized_buffer_ = {};
+        std::span<const std::uint8_t> read_buffer_ = {};
+        std::vector<std::unique_ptr<std::uint8_t[]>> view_copies_ = {};
     };
 }
 
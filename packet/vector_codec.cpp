@@ -0,0 +1,1042 @@
+#include "vector_codec.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ACC_SIMD_X64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define ACC_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// avx2 kernels are compiled for avx2 on their own and only called once the cpu is known to support it, so the rest
+// of the library keeps running on any x86-64
+#if defined(ACC_SIMD_X64) && !defined(_MSC_VER)
+#define ACC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ACC_TARGET_AVX2
+#endif
+
+using namespace acc::packet::detail;
+
+namespace
+{
+    std::uint32_t zigzag(std::uint32_t value)
+    {
+        return (value << 1) ^ static_cast<std::uint32_t>(static_cast<std::int32_t>(value) >> 31);
+    }
+
+    std::uint32_t unzigzag(std::uint32_t value)
+    {
+        return (value >> 1) ^ (0u - (value & 1));
+    }
+
+    // the simd kernels hand their tails to these, start is where the vector loop stopped
+
+    std::uint32_t delta_or_from(const std::uint32_t *values, std::size_t start, std::size_t count)
+    {
+        std::uint32_t result = 0;
+
+        for (auto i = start; i < count; i++)
+            result |= zigzag(values[i] - (i ? values[i - 1] : 0));
+
+        return result;
+    }
+
+    void delta_encode_from(const std::uint32_t *in, std::uint32_t *out, std::size_t start, std::size_t count)
+    {
+        for (auto i = start; i < count; i++)
+            out[i] = zigzag(in[i] - (i ? in[i - 1] : 0));
+    }
+
+    void delta_decode_from(const std::uint32_t *in, std::uint32_t *out, std::size_t start, std::size_t count, std::uint32_t previous)
+    {
+        for (auto i = start; i < count; i++)
+        {
+            previous += unzigzag(in[i]);
+            out[i] = previous;
+        }
+    }
+
+    void min_max_from(const float *values, std::size_t start, std::size_t count, float &min, float &max)
+    {
+        // nan compares false and is skipped
+        for (auto i = start; i < count; i++)
+        {
+            if (values[i] < min)
+                min = values[i];
+
+            if (values[i] > max)
+                max = values[i];
+        }
+    }
+
+    void byte_swap32_scalar(std::uint32_t *values, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            auto value = values[i];
+            values[i] = (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24);
+        }
+    }
+
+    std::uint32_t or_reduce_scalar(const std::uint32_t *values, std::size_t count)
+    {
+        std::uint32_t result = 0;
+
+        for (std::size_t i = 0; i < count; i++)
+            result |= values[i];
+
+        return result;
+    }
+
+    std::uint32_t zigzag_or_scalar(const std::uint32_t *values, std::size_t count)
+    {
+        std::uint32_t result = 0;
+
+        for (std::size_t i = 0; i < count; i++)
+            result |= zigzag(values[i]);
+
+        return result;
+    }
+
+    std::uint32_t delta_or_scalar(const std::uint32_t *values, std::size_t count)
+    {
+        return delta_or_from(values, 0, count);
+    }
+
+    void zigzag_encode_scalar(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i++)
+            out[i] = zigzag(in[i]);
+    }
+
+    void zigzag_decode_scalar(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i++)
+            out[i] = unzigzag(in[i]);
+    }
+
+    void delta_encode_scalar(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        delta_encode_from(in, out, 0, count);
+    }
+
+    void delta_decode_scalar(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        delta_decode_from(in, out, 0, count, 0);
+    }
+
+    void min_max_scalar(const float *values, std::size_t count, float &min, float &max)
+    {
+        min = std::numeric_limits<float>::infinity();
+        max = -std::numeric_limits<float>::infinity();
+
+        min_max_from(values, 0, count, min, max);
+    }
+
+    // nan quantizes to 0, like any value below the range
+    void quantize_scalar(const float *in, std::uint32_t *out, std::size_t count, float min, float scale, float max_step)
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            auto step = (in[i] - min) * scale + 0.5f;
+            step = step > 0.0f ? step : 0.0f;
+            step = step < max_step ? step : max_step;
+
+            out[i] = static_cast<std::uint32_t>(step);
+        }
+    }
+
+    void dequantize_scalar(const std::uint32_t *in, float *out, std::size_t count, float min, float step)
+    {
+        for (std::size_t i = 0; i < count; i++)
+            out[i] = min + static_cast<float>(in[i]) * step;
+    }
+
+    const vector_kernels scalar_kernels = {
+        simd_scalar,
+        byte_swap32_scalar,
+        or_reduce_scalar,
+        zigzag_or_scalar,
+        delta_or_scalar,
+        zigzag_encode_scalar,
+        zigzag_decode_scalar,
+        delta_encode_scalar,
+        delta_decode_scalar,
+        min_max_scalar,
+        quantize_scalar,
+        dequantize_scalar};
+
+#ifdef ACC_SIMD_X64
+    // sse2 is part of x86-64, so these need no detection
+
+    __m128i zigzag_sse2(__m128i value)
+    {
+        return _mm_xor_si128(_mm_slli_epi32(value, 1), _mm_srai_epi32(value, 31));
+    }
+
+    __m128i unzigzag_sse2(__m128i value)
+    {
+        auto sign = _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(value, _mm_set1_epi32(1)));
+        return _mm_xor_si128(_mm_srli_epi32(value, 1), sign);
+    }
+
+    std::uint32_t horizontal_or_sse2(__m128i value)
+    {
+        value = _mm_or_si128(value, _mm_srli_si128(value, 8));
+        value = _mm_or_si128(value, _mm_srli_si128(value, 4));
+
+        return static_cast<std::uint32_t>(_mm_cvtsi128_si32(value));
+    }
+
+    __m128i load_sse2(const std::uint32_t *values)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+    }
+
+    void store_sse2(std::uint32_t *values, __m128i value)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(values), value);
+    }
+
+    void byte_swap32_sse2(std::uint32_t *values, std::size_t count)
+    {
+        std::size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            auto value = load_sse2(values + i);
+
+            value = _mm_or_si128(_mm_slli_epi32(value, 16), _mm_srli_epi32(value, 16));
+            value = _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+
+            store_sse2(values + i, value);
+        }
+
+        byte_swap32_scalar(values + i, count - i);
+    }
+
+    std::uint32_t or_reduce_sse2(const std::uint32_t *values, std::size_t count)
+    {
+        auto result = _mm_setzero_si128();
+        std::size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+            result = _mm_or_si128(result, load_sse2(values + i));
+
+        return horizontal_or_sse2(result) | or_reduce_scalar(values + i, count - i);
+    }
+
+    std::uint32_t zigzag_or_sse2(const std::uint32_t *values, std::size_t count)
+    {
+        auto result = _mm_setzero_si128();
+        std::size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+            result = _mm_or_si128(result, zigzag_sse2(load_sse2(values + i)));
+
+        return horizontal_or_sse2(result) | zigzag_or_scalar(values + i, count - i);
+    }
+
+    std::uint32_t delta_or_sse2(const std::uint32_t *values, std::size_t count)
+    {
+        if (!count)
+            return 0;
+
+        auto result = _mm_setzero_si128();
+        std::size_t i = 1;
+
+        // the previous values are the same load shifted back by one element
+        for (; i + 4 <= count; i += 4)
+            result = _mm_or_si128(result, zigzag_sse2(_mm_sub_epi32(load_sse2(values + i), load_sse2(values + i - 1))));
+
+        return horizontal_or_sse2(result) | zigzag(values[0]) | delta_or_from(values, i, count);
+    }
+
+    void zigzag_encode_sse2(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        std::size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+            store_sse2(out + i, zigzag_sse2(load_sse2(in + i)));
+
+        zigzag_encode_scalar(in + i, out + i, count - i);
+    }
+
+    void zigzag_decode_sse2(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        std::size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+            store_sse2(out + i, unzigzag_sse2(load_sse2(in + i)));
+
+        zigzag_decode_scalar(in + i, out + i, count - i);
+    }
+
+    void delta_encode_sse2(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        if (!count)
+            return;
+
+        out[0] = zigzag(in[0]);
+        std::size_t i = 1;
+
+        for (; i + 4 <= count; i += 4)
+            store_sse2(out + i, zigzag_sse2(_mm_sub_epi32(load_sse2(in + i), load_sse2(in + i - 1))));
+
+        delta_encode_from(in, out, i, count);
+    }
+
+    void delta_decode_sse2(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        auto carry = _mm_setzero_si128();
+        std::size_t i = 0;
+
+        // prefix sum in log steps, then the running total of the previous block is added to every lane
+        for (; i + 4 <= count; i += 4)
+        {
+            auto value = unzigzag_sse2(load_sse2(in + i));
+
+            value = _mm_add_epi32(value, _mm_slli_si128(value, 4));
+            value = _mm_add_epi32(value, _mm_slli_si128(value, 8));
+            value = _mm_add_epi32(value, carry);
+
+            store_sse2(out + i, value);
+            carry = _mm_shuffle_epi32(value, 0xff);
+        }
+
+        delta_decode_from(in, out, i, count, static_cast<std::uint32_t>(_mm_cvtsi128_si32(carry)));
+    }
+
+    void min_max_sse2(const float *values, std::size_t count, float &min, float &max)
+    {
+        auto low = _mm_set1_ps(std::numeric_limits<float>::infinity());
+        auto high = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+        std::size_t i = 0;
+
+        // minps and maxps return their second operand when either is nan, which keeps nan out of the accumulators
+        for (; i + 4 <= count; i += 4)
+        {
+            auto value = _mm_loadu_ps(values + i);
+
+            low = _mm_min_ps(value, low);
+            high = _mm_max_ps(value, high);
+        }
+
+        float lows[4] = {}, highs[4] = {};
+        _mm_storeu_ps(lows, low);
+        _mm_storeu_ps(highs, high);
+
+        min = *std::min_element(lows, lows + 4);
+        max = *std::max_element(highs, highs + 4);
+
+        min_max_from(values, i, count, min, max);
+    }
+
+    void quantize_sse2(const float *in, std::uint32_t *out, std::size_t count, float min, float scale, float max_step)
+    {
+        auto offset = _mm_set1_ps(min);
+        auto factor = _mm_set1_ps(scale);
+        auto half = _mm_set1_ps(0.5f);
+        auto zero = _mm_setzero_ps();
+        auto top = _mm_set1_ps(max_step);
+        std::size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            auto step = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(in + i), offset), factor), half);
+
+            step = _mm_min_ps(_mm_max_ps(step, zero), top);
+
+            store_sse2(out + i, _mm_cvttps_epi32(step));
+        }
+
+        quantize_scalar(in + i, out + i, count - i, min, scale, max_step);
+    }
+
+    void dequantize_sse2(const std::uint32_t *in, float *out, std::size_t count, float min, float step)
+    {
+        auto offset = _mm_set1_ps(min);
+        auto factor = _mm_set1_ps(step);
+        std::size_t i = 0;
+
+        // steps are at most 24 bits wide and convert exactly as signed integers
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_ps(out + i, _mm_add_ps(offset, _mm_mul_ps(_mm_cvtepi32_ps(load_sse2(in + i)), factor)));
+
+        dequantize_scalar(in + i, out + i, count - i, min, step);
+    }
+
+    const vector_kernels sse2_kernels = {
+        simd_sse2,
+        byte_swap32_sse2,
+        or_reduce_sse2,
+        zigzag_or_sse2,
+        delta_or_sse2,
+        zigzag_encode_sse2,
+        zigzag_decode_sse2,
+        delta_encode_sse2,
+        delta_decode_sse2,
+        min_max_sse2,
+        quantize_sse2,
+        dequantize_sse2};
+
+    ACC_TARGET_AVX2 __m256i zigzag_avx2(__m256i value)
+    {
+        return _mm256_xor_si256(_mm256_slli_epi32(value, 1), _mm256_srai_epi32(value, 31));
+    }
+
+    ACC_TARGET_AVX2 __m256i unzigzag_avx2(__m256i value)
+    {
+        auto sign = _mm256_sub_epi32(_mm256_setzero_si256(), _mm256_and_si256(value, _mm256_set1_epi32(1)));
+        return _mm256_xor_si256(_mm256_srli_epi32(value, 1), sign);
+    }
+
+    ACC_TARGET_AVX2 std::uint32_t horizontal_or_avx2(__m256i value)
+    {
+        return horizontal_or_sse2(_mm_or_si128(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1)));
+    }
+
+    ACC_TARGET_AVX2 __m256i load_avx2(const std::uint32_t *values)
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values));
+    }
+
+    ACC_TARGET_AVX2 void store_avx2(std::uint32_t *values, __m256i value)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(values), value);
+    }
+
+    ACC_TARGET_AVX2 void byte_swap32_avx2(std::uint32_t *values, std::size_t count)
+    {
+        auto order = _mm256_setr_epi8(
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        std::size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+            store_avx2(values + i, _mm256_shuffle_epi8(load_avx2(values + i), order));
+
+        byte_swap32_sse2(values + i, count - i);
+    }
+
+    ACC_TARGET_AVX2 std::uint32_t or_reduce_avx2(const std::uint32_t *values, std::size_t count)
+    {
+        auto result = _mm256_setzero_si256();
+        std::size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+            result = _mm256_or_si256(result, load_avx2(values + i));
+
+        return horizontal_or_avx2(result) | or_reduce_scalar(values + i, count - i);
+    }
+
+    ACC_TARGET_AVX2 std::uint32_t zigzag_or_avx2(const std::uint32_t *values, std::size_t count)
+    {
+        auto result = _mm256_setzero_si256();
+        std::size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+            result = _mm256_or_si256(result, zigzag_avx2(load_avx2(values + i)));
+
+        return horizontal_or_avx2(result) | zigzag_or_scalar(values + i, count - i);
+    }
+
+    ACC_TARGET_AVX2 std::uint32_t delta_or_avx2(const std::uint32_t *values, std::size_t count)
+    {
+        if (!count)
+            return 0;
+
+        auto result = _mm256_setzero_si256();
+        std::size_t i = 1;
+
+        for (; i + 8 <= count; i += 8)
+            result = _mm256_or_si256(result, zigzag_avx2(_mm256_sub_epi32(load_avx2(values + i), load_avx2(values + i - 1))));
+
+        return horizontal_or_avx2(result) | zigzag(values[0]) | delta_or_from(values, i, count);
+    }
+
+    ACC_TARGET_AVX2 void zigzag_encode_avx2(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        std::size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+            store_avx2(out + i, zigzag_avx2(load_avx2(in + i)));
+
+        zigzag_encode_scalar(in + i, out + i, count - i);
+    }
+
+    ACC_TARGET_AVX2 void zigzag_decode_avx2(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        std::size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+            store_avx2(out + i, unzigzag_avx2(load_avx2(in + i)));
+
+        zigzag_decode_scalar(in + i, out + i, count - i);
+    }
+
+    ACC_TARGET_AVX2 void delta_encode_avx2(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        if (!count)
+            return;
+
+        out[0] = zigzag(in[0]);
+        std::size_t i = 1;
+
+        for (; i + 8 <= count; i += 8)
+            store_avx2(out + i, zigzag_avx2(_mm256_sub_epi32(load_avx2(in + i), load_avx2(in + i - 1))));
+
+        delta_encode_from(in, out, i, count);
+    }
+
+    ACC_TARGET_AVX2 void delta_decode_avx2(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        auto carry = _mm256_setzero_si256();
+        auto last = _mm256_set1_epi32(7);
+        std::size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            auto value = unzigzag_avx2(load_avx2(in + i));
+
+            // byte shifts stay within each 128 bit lane, the low lane's total is then carried into the high lane
+            value = _mm256_add_epi32(value, _mm256_slli_si256(value, 4));
+            value = _mm256_add_epi32(value, _mm256_slli_si256(value, 8));
+
+            auto low_total = _mm256_shuffle_epi32(value, 0xff);
+            value = _mm256_add_epi32(value, _mm256_permute2x128_si256(low_total, low_total, 0x08));
+            value = _mm256_add_epi32(value, carry);
+
+            store_avx2(out + i, value);
+            carry = _mm256_permutevar8x32_epi32(value, last);
+        }
+
+        delta_decode_from(in, out, i, count, static_cast<std::uint32_t>(_mm_cvtsi128_si32(_mm256_castsi256_si128(carry))));
+    }
+
+    ACC_TARGET_AVX2 void min_max_avx2(const float *values, std::size_t count, float &min, float &max)
+    {
+        auto low = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+        auto high = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+        std::size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            auto value = _mm256_loadu_ps(values + i);
+
+            low = _mm256_min_ps(value, low);
+            high = _mm256_max_ps(value, high);
+        }
+
+        float lows[8] = {}, highs[8] = {};
+        _mm256_storeu_ps(lows, low);
+        _mm256_storeu_ps(highs, high);
+
+        min = *std::min_element(lows, lows + 8);
+        max = *std::max_element(highs, highs + 8);
+
+        min_max_from(values, i, count, min, max);
+    }
+
+    ACC_TARGET_AVX2 void quantize_avx2(const float *in, std::uint32_t *out, std::size_t count, float min, float scale, float max_step)
+    {
+        auto offset = _mm256_set1_ps(min);
+        auto factor = _mm256_set1_ps(scale);
+        auto half = _mm256_set1_ps(0.5f);
+        auto zero = _mm256_setzero_ps();
+        auto top = _mm256_set1_ps(max_step);
+        std::size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            auto step = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(in + i), offset), factor), half);
+
+            step = _mm256_min_ps(_mm256_max_ps(step, zero), top);
+
+            store_avx2(out + i, _mm256_cvttps_epi32(step));
+        }
+
+        quantize_scalar(in + i, out + i, count - i, min, scale, max_step);
+    }
+
+    ACC_TARGET_AVX2 void dequantize_avx2(const std::uint32_t *in, float *out, std::size_t count, float min, float step)
+    {
+        auto offset = _mm256_set1_ps(min);
+        auto factor = _mm256_set1_ps(step);
+        std::size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+            _mm256_storeu_ps(out + i, _mm256_add_ps(offset, _mm256_mul_ps(_mm256_cvtepi32_ps(load_avx2(in + i)), factor)));
+
+        dequantize_scalar(in + i, out + i, count - i, min, step);
+    }
+
+    const vector_kernels avx2_kernels = {
+        simd_avx2,
+        byte_swap32_avx2,
+        or_reduce_avx2,
+        zigzag_or_avx2,
+        delta_or_avx2,
+        zigzag_encode_avx2,
+        zigzag_decode_avx2,
+        delta_encode_avx2,
+        delta_decode_avx2,
+        min_max_avx2,
+        quantize_avx2,
+        dequantize_avx2};
+#endif
+
+#ifdef ACC_SIMD_NEON
+    // neon is part of aarch64, so these need no detection
+
+    uint32x4_t zigzag_neon(uint32x4_t value)
+    {
+        auto sign = vreinterpretq_u32_s32(vshrq_n_s32(vreinterpretq_s32_u32(value), 31));
+        return veorq_u32(vshlq_n_u32(value, 1), sign);
+    }
+
+    uint32x4_t unzigzag_neon(uint32x4_t value)
+    {
+        auto sign = vreinterpretq_u32_s32(vnegq_s32(vreinterpretq_s32_u32(vandq_u32(value, vdupq_n_u32(1)))));
+        return veorq_u32(vshrq_n_u32(value, 1), sign);
+    }
+
+    std::uint32_t horizontal_or_neon(uint32x4_t value)
+    {
+        value = vorrq_u32(value, vextq_u32(value, value, 2));
+        value = vorrq_u32(value, vextq_u32(value, value, 1));
+
+        return vgetq_lane_u32(value, 0);
+    }
+
+    void byte_swap32_neon(std::uint32_t *values, std::size_t count)
+    {
+        std::size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+            vst1q_u32(values + i, vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(vld1q_u32(values + i)))));
+
+        byte_swap32_scalar(values + i, count - i);
+    }
+
+    std::uint32_t or_reduce_neon(const std::uint32_t *values, std::size_t count)
+    {
+        auto result = vdupq_n_u32(0);
+        std::size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+            result = vorrq_u32(result, vld1q_u32(values + i));
+
+        return horizontal_or_neon(result) | or_reduce_scalar(values + i, count - i);
+    }
+
+    std::uint32_t zigzag_or_neon(const std::uint32_t *values, std::size_t count)
+    {
+        auto result = vdupq_n_u32(0);
+        std::size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+            result = vorrq_u32(result, zigzag_neon(vld1q_u32(values + i)));
+
+        return horizontal_or_neon(result) | zigzag_or_scalar(values + i, count - i);
+    }
+
+    std::uint32_t delta_or_neon(const std::uint32_t *values, std::size_t count)
+    {
+        if (!count)
+            return 0;
+
+        auto result = vdupq_n_u32(0);
+        std::size_t i = 1;
+
+        for (; i + 4 <= count; i += 4)
+            result = vorrq_u32(result, zigzag_neon(vsubq_u32(vld1q_u32(values + i), vld1q_u32(values + i - 1))));
+
+        return horizontal_or_neon(result) | zigzag(values[0]) | delta_or_from(values, i, count);
+    }
+
+    void zigzag_encode_neon(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        std::size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+            vst1q_u32(out + i, zigzag_neon(vld1q_u32(in + i)));
+
+        zigzag_encode_scalar(in + i, out + i, count - i);
+    }
+
+    void zigzag_decode_neon(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        std::size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+            vst1q_u32(out + i, unzigzag_neon(vld1q_u32(in + i)));
+
+        zigzag_decode_scalar(in + i, out + i, count - i);
+    }
+
+    void delta_encode_neon(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        if (!count)
+            return;
+
+        out[0] = zigzag(in[0]);
+        std::size_t i = 1;
+
+        for (; i + 4 <= count; i += 4)
+            vst1q_u32(out + i, zigzag_neon(vsubq_u32(vld1q_u32(in + i), vld1q_u32(in + i - 1))));
+
+        delta_encode_from(in, out, i, count);
+    }
+
+    void delta_decode_neon(const std::uint32_t *in, std::uint32_t *out, std::size_t count)
+    {
+        auto zero = vdupq_n_u32(0);
+        std::uint32_t carry = 0;
+        std::size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            auto value = unzigzag_neon(vld1q_u32(in + i));
+
+            value = vaddq_u32(value, vextq_u32(zero, value, 3));
+            value = vaddq_u32(value, vextq_u32(zero, value, 2));
+            value = vaddq_u32(value, vdupq_n_u32(carry));
+
+            vst1q_u32(out + i, value);
+            carry = vgetq_lane_u32(value, 3);
+        }
+
+        delta_decode_from(in, out, i, count, carry);
+    }
+
+    void min_max_neon(const float *values, std::size_t count, float &min, float &max)
+    {
+        auto low = vdupq_n_f32(std::numeric_limits<float>::infinity());
+        auto high = vdupq_n_f32(-std::numeric_limits<float>::infinity());
+        std::size_t i = 0;
+
+        // the nm variants ignore nan
+        for (; i + 4 <= count; i += 4)
+        {
+            auto value = vld1q_f32(values + i);
+
+            low = vminnmq_f32(low, value);
+            high = vmaxnmq_f32(high, value);
+        }
+
+        min = vminnmvq_f32(low);
+        max = vmaxnmvq_f32(high);
+
+        min_max_from(values, i, count, min, max);
+    }
+
+    void quantize_neon(const float *in, std::uint32_t *out, std::size_t count, float min, float scale, float max_step)
+    {
+        auto offset = vdupq_n_f32(min);
+        auto factor = vdupq_n_f32(scale);
+        auto half = vdupq_n_f32(0.5f);
+        auto zero = vdupq_n_f32(0.0f);
+        auto top = vdupq_n_f32(max_step);
+        std::size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            auto step = vaddq_f32(vmulq_f32(vsubq_f32(vld1q_f32(in + i), offset), factor), half);
+
+            step = vminq_f32(vmaxnmq_f32(step, zero), top);
+
+            vst1q_u32(out + i, vcvtq_u32_f32(step));
+        }
+
+        quantize_scalar(in + i, out + i, count - i, min, scale, max_step);
+    }
+
+    void dequantize_neon(const std::uint32_t *in, float *out, std::size_t count, float min, float step)
+    {
+        auto offset = vdupq_n_f32(min);
+        auto factor = vdupq_n_f32(step);
+        std::size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+            vst1q_f32(out + i, vaddq_f32(offset, vmulq_f32(vcvtq_f32_u32(vld1q_u32(in + i)), factor)));
+
+        dequantize_scalar(in + i, out + i, count - i, min, step);
+    }
+
+    const vector_kernels neon_kernels = {
+        simd_neon,
+        byte_swap32_neon,
+        or_reduce_neon,
+        zigzag_or_neon,
+        delta_or_neon,
+        zigzag_encode_neon,
+        zigzag_decode_neon,
+        delta_encode_neon,
+        delta_decode_neon,
+        min_max_neon,
+        quantize_neon,
+        dequantize_neon};
+#endif
+
+    std::uint32_t *scratch(std::size_t count)
+    {
+        thread_local std::vector<std::uint32_t> buffer = {};
+
+        if (buffer.size() < count)
+            buffer.resize(count);
+
+        return buffer.data();
+    }
+}
+
+simd_level acc::packet::detail::detect_simd_level()
+{
+#if defined(ACC_SIMD_X64) && defined(_MSC_VER)
+    int info[4] = {};
+
+    __cpuid(info, 0);
+
+    if (info[0] < 7)
+        return simd_sse2;
+
+    // the os has to save the ymm registers as well
+    __cpuid(info, 1);
+
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6)
+        return simd_sse2;
+
+    __cpuidex(info, 7, 0);
+
+    return info[1] & (1 << 5) ? simd_avx2 : simd_sse2;
+#elif defined(ACC_SIMD_X64)
+    return __builtin_cpu_supports("avx2") ? simd_avx2 : simd_sse2;
+#elif defined(ACC_SIMD_NEON)
+    return simd_neon;
+#else
+    return simd_scalar;
+#endif
+}
+
+const vector_kernels &acc::packet::detail::get_vector_kernels(simd_level level)
+{
+#if defined(ACC_SIMD_X64)
+    static const auto supported = detect_simd_level();
+
+    if (level == simd_avx2 && supported == simd_avx2)
+        return avx2_kernels;
+
+    if (level == simd_avx2 || level == simd_sse2)
+        return sse2_kernels;
+#elif defined(ACC_SIMD_NEON)
+    if (level == simd_neon)
+        return neon_kernels;
+#endif
+
+    return scalar_kernels;
+}
+
+const vector_kernels &acc::packet::detail::get_vector_kernels()
+{
+    static const auto &kernels = get_vector_kernels(detect_simd_level());
+    return kernels;
+}
+
+std::size_t acc::packet::detail::packed_bytes(std::size_t count, std::size_t bits)
+{
+    return (static_cast<std::uint64_t>(count) * bits + 7) / 8;
+}
+
+void acc::packet::detail::bit_pack(const std::uint32_t *in, std::size_t count, std::size_t bits, std::uint8_t *out)
+{
+    std::uint64_t buffer = 0;
+    std::size_t filled = 0;
+
+    // values are appended from the least significant bit up and flushed 32 bits at a time
+    for (std::size_t i = 0; i < count; i++)
+    {
+        buffer |= static_cast<std::uint64_t>(in[i]) << filled;
+        filled += bits;
+
+        if (filled >= 32)
+        {
+            auto word = little_endian(static_cast<std::uint32_t>(buffer));
+            memcpy(out, &word, sizeof(word));
+
+            out += sizeof(word);
+            buffer >>= 32;
+            filled -= 32;
+        }
+    }
+
+    for (; filled > 0; filled -= std::min<std::size_t>(filled, 8))
+    {
+        *out++ = static_cast<std::uint8_t>(buffer);
+        buffer >>= 8;
+    }
+}
+
+void acc::packet::detail::bit_unpack(const std::uint8_t *in, std::size_t count, std::size_t bits, std::uint32_t *out)
+{
+    auto end = in + packed_bytes(count, bits);
+    auto mask = (std::uint64_t(1) << bits) - 1;
+
+    std::uint64_t buffer = 0;
+    std::size_t filled = 0;
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        if (filled < bits)
+        {
+            // refilled a word at a time while one is left, the last few bytes one by one
+            if (end - in >= 4)
+            {
+                std::uint32_t word = 0;
+                memcpy(&word, in, sizeof(word));
+
+                buffer |= static_cast<std::uint64_t>(little_endian(word)) << filled;
+                filled += 32;
+                in += sizeof(word);
+            }
+            else
+            {
+                while (filled < bits)
+                {
+                    buffer |= static_cast<std::uint64_t>(*in++) << filled;
+                    filled += 8;
+                }
+            }
+        }
+
+        out[i] = static_cast<std::uint32_t>(buffer & mask);
+        buffer >>= bits;
+        filled -= bits;
+    }
+}
+
+packed_plan acc::packet::detail::plan_packed(const std::uint32_t *values, std::size_t count, bool is_signed)
+{
+    auto &kernels = get_vector_kernels();
+
+    auto plain_width = static_cast<int>(std::bit_width(is_signed ? kernels.zigzag_or(values, count) : kernels.or_reduce(values, count)));
+    auto delta_width = static_cast<int>(std::bit_width(kernels.delta_or(values, count)));
+
+    packed_plan plan = {};
+    plan.delta = delta_width < plain_width;
+
+    // at least a bit per value, so a received count is bounded by the bytes that follow it
+    plan.bits = static_cast<std::uint8_t>(std::max(1, plan.delta ? delta_width : plain_width));
+
+    return plan;
+}
+
+std::size_t acc::packet::detail::packed_size(std::size_t count, const packed_plan &plan)
+{
+    return count ? 1 + packed_bytes(count, plan.bits) : 0;
+}
+
+std::uint8_t *acc::packet::detail::encode_packed(const std::uint32_t *values, std::size_t count, bool is_signed, const packed_plan &plan, std::uint8_t *out)
+{
+    if (!count)
+        return out;
+
+    auto &kernels = get_vector_kernels();
+
+    *out++ = static_cast<std::uint8_t>(plan.bits | (plan.delta ? 0x80 : 0));
+
+    auto source = values;
+
+    if (plan.delta || is_signed)
+    {
+        auto transformed = scratch(count);
+
+        if (plan.delta)
+            kernels.delta_encode(values, transformed, count);
+        else
+            kernels.zigzag_encode(values, transformed, count);
+
+        source = transformed;
+    }
+
+    bit_pack(source, count, plan.bits, out);
+
+    return out + packed_bytes(count, plan.bits);
+}
+
+bool acc::packet::detail::decode_mode(std::uint8_t mode, packed_plan &plan)
+{
+    plan.bits = mode & 0x7f;
+    plan.delta = mode & 0x80;
+
+    return plan.bits >= 1 && plan.bits <= 32;
+}
+
+void acc::packet::detail::decode_packed(const std::uint8_t *in, std::size_t count, bool is_signed, const packed_plan &plan, std::uint32_t *out)
+{
+    auto &kernels = get_vector_kernels();
+
+    bit_unpack(in, count, plan.bits, out);
+
+    if (plan.delta)
+        kernels.delta_decode(out, out, count);
+    else if (is_signed)
+        kernels.zigzag_decode(out, out, count);
+}
+
+std::size_t acc::packet::detail::quantized_size(std::size_t count, std::size_t bits)
+{
+    return count ? 2 * sizeof(float) + packed_bytes(count, bits) : 0;
+}
+
+std::uint8_t *acc::packet::detail::encode_quantized(const float *values, std::size_t count, std::size_t bits, std::uint8_t *out)
+{
+    if (!count)
+        return out;
+
+    auto &kernels = get_vector_kernels();
+
+    float min = 0, max = 0;
+    kernels.min_max(values, count, min, max);
+
+    // nothing but nan
+    if (!(min <= max))
+        min = max = 0;
+
+    auto max_step = static_cast<float>((std::uint32_t(1) << bits) - 1);
+    auto scale = max > min ? max_step / (max - min) : 0.0f;
+
+    out = write_compact(out, min);
+    out = write_compact(out, max);
+
+    auto steps = scratch(count);
+    kernels.quantize(values, steps, count, min, scale, max_step);
+
+    bit_pack(steps, count, bits, out);
+
+    return out + packed_bytes(count, bits);
+}
+
+void acc::packet::detail::decode_quantized(const std::uint8_t *in, std::size_t count, std::size_t bits, float *out)
+{
+    float min = 0, max = 0;
+
+    memcpy(&min, in, sizeof(min));
+    memcpy(&max, in + sizeof(min), sizeof(max));
+
+    min = little_endian(min);
+    max = little_endian(max);
+
+    auto max_step = static_cast<float>((std::uint32_t(1) << bits) - 1);
+
+    auto steps = scratch(count);
+    bit_unpack(in + 2 * sizeof(float), count, bits, steps);
+
+    get_vector_kernels().dequantize(steps, out, count, min, (max - min) / max_step);
+}
@@ -0,0 +1,126 @@
+#ifndef VECTOR_CODEC_H
+#define VECTOR_CODEC_H
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "wire_format.hpp"
+
+namespace acc::packet
+{
+    // 32 bit integers sent bit-packed to the width of the widest value, or of the widest difference between
+    // neighbours when that is narrower. suits counters, timestamps and sorted ids
+    template <typename T>
+        requires std::is_integral_v<T> && (sizeof(T) == 4)
+    struct packed_vector
+    {
+        std::vector<T> values = {};
+    };
+
+    // floats sent as Bits bit fixed point across the range of the values, each is off by at most half a step of
+    // (max - min) / (2^Bits - 1). values must be finite
+    template <std::size_t Bits>
+        requires(Bits >= 1 && Bits <= 24)
+    struct quantized_vector
+    {
+        std::vector<float> values = {};
+    };
+}
+
+namespace acc::packet::detail
+{
+    enum simd_level : std::uint8_t
+    {
+        simd_scalar = 0,
+        simd_sse2,
+        simd_avx2,
+        simd_neon
+    };
+
+    // the bulk loops behind the vector codec. decoding kernels may run in place, encoding ones may not
+    struct vector_kernels
+    {
+        simd_level level = simd_scalar;
+
+        void (*byte_swap32)(std::uint32_t *values, std::size_t count) = nullptr;
+
+        std::uint32_t (*or_reduce)(const std::uint32_t *values, std::size_t count) = nullptr;
+        std::uint32_t (*zigzag_or)(const std::uint32_t *values, std::size_t count) = nullptr;
+        std::uint32_t (*delta_or)(const std::uint32_t *values, std::size_t count) = nullptr;
+
+        void (*zigzag_encode)(const std::uint32_t *in, std::uint32_t *out, std::size_t count) = nullptr;
+        void (*zigzag_decode)(const std::uint32_t *in, std::uint32_t *out, std::size_t count) = nullptr;
+
+        // zigzagged differences to the previous value, the first value is taken against 0
+        void (*delta_encode)(const std::uint32_t *in, std::uint32_t *out, std::size_t count) = nullptr;
+        void (*delta_decode)(const std::uint32_t *in, std::uint32_t *out, std::size_t count) = nullptr;
+
+        void (*min_max)(const float *values, std::size_t count, float &min, float &max) = nullptr;
+        void (*quantize)(const float *in, std::uint32_t *out, std::size_t count, float min, float scale, float max_step) = nullptr;
+        void (*dequantize)(const std::uint32_t *in, float *out, std::size_t count, float min, float step) = nullptr;
+    };
+
+    // the best level the cpu supports, detected once
+    simd_level detect_simd_level();
+
+    // kernels for the given level, or the best available below it
+    const vector_kernels &get_vector_kernels(simd_level level);
+    const vector_kernels &get_vector_kernels();
+
+    struct packed_plan
+    {
+        std::uint8_t bits = 0;
+        bool delta = false;
+    };
+
+    std::size_t packed_bytes(std::size_t count, std::size_t bits);
+
+    void bit_pack(const std::uint32_t *in, std::size_t count, std::size_t bits, std::uint8_t *out);
+    void bit_unpack(const std::uint8_t *in, std::size_t count, std::size_t bits, std::uint32_t *out);
+
+    // a packed array is its mode byte, the bit width with the top bit set for deltas, followed by the packed values
+    packed_plan plan_packed(const std::uint32_t *values, std::size_t count, bool is_signed);
+    std::size_t packed_size(std::size_t count, const packed_plan &plan);
+    std::uint8_t *encode_packed(const std::uint32_t *values, std::size_t count, bool is_signed, const packed_plan &plan, std::uint8_t *out);
+
+    // false if the mode byte is invalid, in must hold packed_bytes(count, bits) bytes
+    bool decode_mode(std::uint8_t mode, packed_plan &plan);
+    void decode_packed(const std::uint8_t *in, std::size_t count, bool is_signed, const packed_plan &plan, std::uint32_t *out);
+
+    // a quantized array is its little-endian float min and max followed by the packed steps
+    std::size_t quantized_size(std::size_t count, std::size_t bits);
+    std::uint8_t *encode_quantized(const float *values, std::size_t count, std::size_t bits, std::uint8_t *out);
+    void decode_quantized(const std::uint8_t *in, std::size_t count, std::size_t bits, float *out);
+
+    // converts an array between host and little-endian order in place
+    template <typename T>
+    void swap_little_endian(T *values, std::size_t count)
+    {
+        if constexpr (std::endian::native == std::endian::little || sizeof(T) == 1)
+            return;
+        else if constexpr (sizeof(T) == 4)
+            get_vector_kernels().byte_swap32(reinterpret_cast<std::uint32_t *>(values), count);
+        else
+        {
+            for (std::size_t i = 0; i < count; i++)
+                values[i] = little_endian(values[i]);
+        }
+    }
+
+    // arithmetic arrays keep their elements at full width in the compact encoding, a plain copy on little-endian hosts
+    template <typename T>
+    std::uint8_t *write_little_endian(std::uint8_t *out, const T *values, std::size_t count)
+    {
+        if (!count)
+            return out;
+
+        memcpy(out, values, count * sizeof(T));
+        swap_little_endian(reinterpret_cast<T *>(out), count);
+
+        return out + count * sizeof(T);
+    }
+}
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef WIRE_FORMAT_H
+#define WIRE_FORMAT_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace acc::packet
+{
+    // fixed is the original encoding: values at full width in host byte order and uint32 length prefixes. compact
+    // writes integers and lengths as LEB128 varints, zigzagged when signed, and everything else in little-endian order
+    enum encoding : std::uint8_t
+    {
+        enc_fixed = 0,
+        enc_compact
+    };
+}
+
+namespace acc::packet::detail
+{
+    constexpr std::size_t max_varint_size = 10;
+
+    // single byte values gain nothing from a varint and are written as they are
+    template <typename T>
+    constexpr bool varint_encoded = std::is_integral_v<T> && sizeof(T) > 1;
+
+    inline std::size_t varint_size(std::uint64_t value)
+    {
+        std::size_t size = 1;
+
+        while (value >= 0x80)
+        {
+            value >>= 7;
+            size++;
+        }
+
+        return size;
+    }
+
+    inline std::uint8_t *write_varint(std::uint8_t *out, std::uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            *out++ = static_cast<std::uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+
+        *out++ = static_cast<std::uint8_t>(value);
+        return out;
+    }
+
+    // returns nullptr if the varint is truncated or does not fit in 64 bits
+    inline const std::uint8_t *read_varint(const std::uint8_t *in, const std::uint8_t *end, std::uint64_t &value)
+    {
+        value = 0;
+
+        for (unsigned int shift = 0; shift < 64 && in != end; shift += 7)
+        {
+            auto byte = *in++;
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+
+            if (!(byte & 0x80))
+                return shift == 63 && byte > 1 ? nullptr : in;
+        }
+
+        return nullptr;
+    }
+
+    template <typename T>
+    std::uint64_t to_varint(T value)
+    {
+        if constexpr (std::is_signed_v<T>)
+        {
+            using U = std::make_unsigned_t<T>;
+            return static_cast<U>(static_cast<U>(value) << 1) ^ static_cast<U>(value >> (sizeof(T) * 8 - 1));
+        }
+        else
+            return value;
+    }
+
+    // false if the decoded value does not fit in T
+    template <typename T>
+    bool from_varint(std::uint64_t raw, T &value)
+    {
+        using U = std::make_unsigned_t<T>;
+
+        if (raw > std::numeric_limits<U>::max())
+            return false;
+
+        auto bits = static_cast<U>(raw);
+
+        if constexpr (std::is_signed_v<T>)
+            value = static_cast<T>(static_cast<U>(bits >> 1) ^ static_cast<U>(~(bits & 1) + 1));
+        else
+            value = bits;
+
+        return true;
+    }
+
+    // converts between host and little-endian order, in either direction
+    template <typename T>
+    T little_endian(T value)
+    {
+        if constexpr (std::endian::native == std::endian::little || sizeof(T) == 1)
+            return value;
+        else
+        {
+            std::uint8_t bytes[sizeof(T)] = {};
+            memcpy(bytes, &value, sizeof(T));
+            std::reverse(bytes, bytes + sizeof(T));
+            memcpy(&value, bytes, sizeof(T));
+
+            return value;
+        }
+    }
+
+    template <typename T>
+    std::size_t compact_size(T value)
+    {
+        if constexpr (varint_encoded<T>)
+            return varint_size(to_varint(value));
+        else
+            return sizeof(T);
+    }
+
+    template <typename T>
+    std::uint8_t *write_compact(std::uint8_t *out, T value)
+    {
+        if constexpr (varint_encoded<T>)
+            return write_varint(out, to_varint(value));
+        else
+        {
+            value = little_endian(value);
+            memcpy(out, &value, sizeof(T));
+
+            return out + sizeof(T);
+        }
+    }
+
+    // returns nullptr if the input is truncated or out of range for T
+    template <typename T>
+    const std::uint8_t *read_compact(const std::uint8_t *in, const std::uint8_t *end, T &value)
+    {
+        if constexpr (varint_encoded<T>)
+        {
+            std::uint64_t raw = 0;
+            in = read_varint(in, end, raw);
+
+            return in && from_varint(raw, value) ? in : nullptr;
+        }
+        else
+        {
+            if (static_cast<std::size_t>(end - in) < sizeof(T))
+                return nullptr;
+
+            memcpy(&value, in, sizeof(T));
+            value = little_endian(value);
+
+            return in + sizeof(T);
+        }
+    }
+}
+
+#endif
@@ -1,12 +1,7 @@
 #include "server.hpp"
 
-#define PACKET_PROCESS(ID, name) void name(acc::async_connect_server *const sv, const SOCKET from, const acc::packet::packet_id id, acc::packet::detail::serializer &s)
-
-PACKET_PROCESS(acc::packet::id_example, on_example_packet)
+void on_example_packet(acc::async_connect_server *const sv, const acc::connection_id from, acc::packet::example_packet &example)
 {
-    // read packet
-    acc::packet::example_packet example(s);
-
     // access the data
     for (std::size_t i = 0; i < example.some_string_array.size(); i++)
         printf("[ %i ] %s\n", i, example.some_string_array[i].data());
@@ -14,7 +9,17 @@ PACKET_PROCESS(acc::packet::id_example, on_example_packet)
     // answer client
     example.some_string_array = {"Hello", "from", "server!"};
 
-    sv->send_packet(from, &example);
+    sv->send_packet(from, example);
+}
+
+void on_example_call(acc::async_connect_server *const sv, const acc::connection_id from, const acc::packet::call_id call, acc::packet::detail::serializer &s)
+{
+    auto request = acc::packet::decode<acc::packet::example_packet>(s);
+
+    // the response may also be sent later from another thread, as long as it carries the call id
+    request.some_string_array = {"Reply", "from", "server!"};
+
+    sv->respond(from, call, request);
 }
 
 int main()
@@ -24,12 +29,12 @@ int main()
         acc::async_connect_server server = {};
 
         // before starting the server setup all callbacks
-        server.register_connect_callback([](acc::async_connect_server *const sv, SOCKET who)
-                                         { printf("Client with socket ID %i has connected.\n", who); });
+        server.register_connect_callback([](acc::async_connect_server *const sv, acc::connection_id who)
+                                         { printf("Client %llu has connected.\n", static_cast<unsigned long long>(who.value)); });
 
-        server.register_disconnect_callback([](acc::async_connect_server *const sv, SOCKET who)
+        server.register_disconnect_callback([](acc::async_connect_server *const sv, acc::connection_id who)
                                             {
-			printf( "Client with socket ID %i has disconnected.\n", who );
+			printf( "Client %llu has disconnected.\n", static_cast<unsigned long long>(who.value) );
 			
 			// stop server
 			sv->stop( ); });
@@ -37,15 +42,13 @@ int main()
         server.register_stop_callback([](acc::async_connect_server *const sv)
                                       { printf("Server has been stopped.\n"); });
 
-        server.register_callback([](acc::async_connect_server *const sv, SOCKET from, const acc::packet::packet_id id, acc::packet::detail::serializer &s)
-                                 {
-			switch ( id ) {
-				case acc::packet::id_example:
-					on_example_packet( sv, from, id, s );
-					break;
-				default:
-					printf( "Unknown packet ID %i received\n", id );
-			} });
+        // packets arrive decoded, those without a handler are counted by get_unknown_packets()
+        server.register_handler<acc::packet::example_packet>(on_example_packet);
+
+        server.register_request_callback([](acc::async_connect_server *const sv, acc::connection_id from, const acc::packet::call_id call, const acc::packet::packet_id id, acc::packet::detail::serializer &s)
+                                         {
+			if ( id == acc::packet::id_example )
+				on_example_call( sv, from, call, s ); });
 
         server.start("1337");
 
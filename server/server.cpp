@@ -2,6 +2,8 @@
 
 using namespace acc;
 
+thread_local async_connect_server::reactor *async_connect_server::reactor::current_ = nullptr;
+
 async_connect_server::async_connect_server()
 {
 #ifdef _WIN32
@@ -13,18 +15,7 @@ async_connect_server::async_connect_server()
 async_connect_server::~async_connect_server()
 {
     stop();
-
-    if (accepting_thread_.joinable())
-        accepting_thread_.join();
-
-    if (processing_thread_.joinable())
-        processing_thread_.join();
-
-    if (receiving_thread_.joinable())
-        receiving_thread_.join();
-
-    if (heartbeat_thread_.joinable())
-        heartbeat_thread_.join();
+    join_reactors();
 
 #ifdef _WIN32
     WSACleanup();
@@ -36,8 +27,7 @@ void async_connect_server::start(std::string_view port)
     if (running_)
         throw exception(exception::reason_id::already_running, "async_connect_server::start: attempted to start server while it was running");
 
-    if (!process_callback_)
-        throw exception(exception::reason_id::no_callback, "async_connect_server::start: no processing callback set");
+    join_reactors();
 
     addrinfo hints = {}, *result = nullptr;
 
@@ -57,65 +47,85 @@ void async_connect_server::start(std::string_view port)
         throw exception(exception::reason_id::socket_failure, "async_connect_server::start: failed to create socket");
     }
 
+#ifndef _WIN32
+    int reuse_address = 1;
+    setsockopt(server_socket_, SOL_SOCKET, SO_REUSEADDR, &reuse_address, sizeof(reuse_address));
+#endif
+
     if (bind(server_socket_, result->ai_addr, result->ai_addrlen) == SOCKET_ERROR)
     {
         freeaddrinfo(result);
+        closesocket(server_socket_);
         throw exception(exception::reason_id::bind_error, "async_connect_server::start: failed to bind socket");
     }
 
     if (listen(server_socket_, SOMAXCONN) == SOCKET_ERROR)
     {
         freeaddrinfo(result);
+        closesocket(server_socket_);
         throw exception(exception::reason_id::listen_error, "async_connect_server::start: failed to listen on socket");
     }
 
     freeaddrinfo(result);
 
-    running_ = true;
+    reactors_.clear();
 
-    accepting_thread_ = std::thread(&async_connect_server::accept_clients, this);
-    processing_thread_ = std::thread(&async_connect_server::process_data, this);
-    receiving_thread_ = std::thread(&async_connect_server::receive_data, this);
-    heartbeat_thread_ = std::thread(&async_connect_server::run_heartbeat, this);
-}
+    for (std::size_t i = 0; i < reactor_count_; i++)
+        reactors_.push_back(std::make_unique<reactor>(this, i));
 
-void async_connect_server::stop()
-{
-    if (running_)
+    // the first reactor owns the listener and hands accepted clients to whichever reactor carries the least connections,
+    // preferring the others on a tie
+    bool opened = std::all_of(reactors_.begin(), reactors_.end(), [](const std::unique_ptr<reactor> &r)
+                              { return r->open(); });
+
+    if (!opened)
     {
-        running_ = false;
+        for (auto &r : reactors_)
+            r->close();
 
-        shutdown(server_socket_, SD_BOTH);
+        reactors_.clear();
         closesocket(server_socket_);
-
-        if (on_stop_callback_)
-            on_stop_callback_(this);
+        throw exception(exception::reason_id::event_loop_failure, "async_connect_server::start: failed to set up io engine");
     }
 
-    connected_clients_.clear();
-    process_buffers_.clear();
-    clients_to_disconnect_.clear();
+    running_ = true;
+
+    if (handler_threads_)
+        handler_pool_.start(handler_threads_);
+
+    for (auto &r : reactors_)
+        r->thread = std::thread(&reactor::run, r.get());
 }
 
-void async_connect_server::disconnect_client(SOCKET who)
+void async_connect_server::stop()
 {
-    std::lock_guard guard1(client_mtx_);
-    std::lock_guard guard2(process_mtx_);
+    if (!running_.exchange(false))
+        return;
+
+    for (auto &r : reactors_)
+        r->wake();
+
+    if (on_stop_callback_)
+        on_stop_callback_(this);
+}
 
-    auto it = std::find_if(connected_clients_.begin(), connected_clients_.end(), [&who](const SOCKET &s)
-                           { return s == who; });
+void async_connect_server::disconnect_client(connection_id who)
+{
+    auto owner = current_reactor();
 
-    if (it == connected_clients_.end())
+    if (owner && owner->owns(who))
+    {
+        owner->close_client(who);
         return;
+    }
 
-    shutdown(who, SD_SEND);
-    closesocket(who);
+    if (!running_)
+        return;
 
-    process_buffers_.erase(who);
-    connected_clients_.erase(it);
+    owner = find_reactor(who);
 
-    if (on_disconnect_callback_)
-        on_disconnect_callback_(this, who);
+    if (owner)
+        owner->queue_disconnect(who);
 }
 
 bool async_connect_server::is_running()
@@ -123,36 +133,188 @@ bool async_connect_server::is_running()
     return running_;
 }
 
-void async_connect_server::send_packet(SOCKET to, packet::base_packet *packet)
+void async_connect_server::send_packet(connection_id to, packet::base_packet *packet)
 {
     if (!packet)
         throw exception(exception::reason_id::packet_nullptr, "async_connect_server::send_packet: packet was nullptr");
 
-    std::lock_guard guard(send_mtx_);
+    route_packet(to, serialize_frame(packet));
+}
+
+void async_connect_server::respond(connection_id to, packet::call_id call, packet::base_packet *packet)
+{
+    if (!packet)
+        throw exception(exception::reason_id::packet_nullptr, "async_connect_server::respond: packet was nullptr");
+
+    route_packet(to, serialize_frame(packet, packet::flags::fl_response, call));
+}
 
-    serializer.reset();
+void async_connect_server::broadcast(packet::base_packet *packet, std::function<bool(const connection_id)> filter)
+{
+    if (!packet)
+        throw exception(exception::reason_id::packet_nullptr, "async_connect_server::broadcast: packet was nullptr");
 
-    packet->serialize(serializer);
+    broadcast_frame(std::make_shared<const std::vector<std::uint8_t>>(serialize_frame(packet)), filter);
+}
 
-    std::vector<std::uint8_t> packet_data(sizeof(packet::header) + serializer.get_serialized_data_length());
+void async_connect_server::send_to_group(std::string_view group, packet::base_packet *packet)
+{
+    if (!packet)
+        throw exception(exception::reason_id::packet_nullptr, "async_connect_server::send_to_group: packet was nullptr");
 
-    packet::header packet_header = construct_packet_header(
-        serializer.get_serialized_data_length(),
-        packet->get_id(),
-        packet::flags::fl_none);
+    group_frame(group, std::make_shared<const std::vector<std::uint8_t>>(serialize_frame(packet)));
+}
 
-    memcpy(packet_data.data(), &packet_header, sizeof(packet::header));
+void async_connect_server::join_group(connection_id who, std::string_view group)
+{
+    auto owner = find_reactor(who);
+
+    if (!owner || !running_)
+        return;
+
+    {
+        std::unique_lock guard(groups_mtx_);
+
+        auto it = groups_.find(group);
+
+        if (it == groups_.end())
+            it = groups_.emplace(std::string(group), std::unordered_set<connection_id>()).first;
+
+        if (!it->second.insert(who).second)
+            return;
+
+        client_groups_[who].push_back(it->first);
+    }
+
+    // a client that disconnected in the meantime already left its groups, its reactor takes it out of this one too
+    if (!owner->is_current())
+        owner->queue_prune(who);
+    else if (!owner->owns(who))
+        leave_groups(who);
+}
+
+void async_connect_server::leave_group(connection_id who, std::string_view group)
+{
+    std::unique_lock guard(groups_mtx_);
+
+    auto it = groups_.find(group);
+
+    if (it == groups_.end() || !it->second.erase(who))
+        return;
+
+    if (it->second.empty())
+        groups_.erase(it);
+
+    auto &names = client_groups_[who];
+    names.erase(std::find(names.begin(), names.end(), group));
+
+    if (names.empty())
+        client_groups_.erase(who);
+}
 
-    memcpy(
-        packet_data.data() + sizeof(packet::header),
-        serializer.get_serialized_data(),
-        serializer.get_serialized_data_length());
+void async_connect_server::set_reactor_count(std::uint32_t count)
+{
+    if (running_)
+        throw exception(exception::reason_id::already_running, "async_connect_server::set_reactor_count: attempted to change reactor count while server was running");
+
+    if (count == 0 || count > max_reactors)
+        throw exception(exception::reason_id::invalid_reactor_count, "async_connect_server::set_reactor_count: reactor count must be between 1 and 256");
+
+    reactor_count_ = count;
+}
+
+void async_connect_server::set_max_elements(std::uint32_t max_elements)
+{
+    if (running_)
+        throw exception(exception::reason_id::already_running, "async_connect_server::set_max_elements: attempted to change element limit while server was running");
+
+    max_elements_ = max_elements;
+}
+
+void async_connect_server::set_coalescing(std::chrono::microseconds window, std::size_t min_bytes)
+{
+    if (running_)
+        throw exception(exception::reason_id::already_running, "async_connect_server::set_coalescing: attempted to change send coalescing while server was running");
+
+    coalescing_window_ = window;
+    coalescing_bytes_ = min_bytes;
+}
+
+void async_connect_server::set_idle_timeout(std::chrono::milliseconds timeout)
+{
+    if (running_)
+        throw exception(exception::reason_id::already_running, "async_connect_server::set_idle_timeout: attempted to change idle timeout while server was running");
+
+    idle_timeout_ = timeout;
+}
+
+void async_connect_server::set_write_timeout(std::chrono::milliseconds timeout)
+{
+    if (running_)
+        throw exception(exception::reason_id::already_running, "async_connect_server::set_write_timeout: attempted to change write timeout while server was running");
+
+    write_timeout_ = timeout;
+}
+
+void async_connect_server::set_handshake_timeout(std::chrono::milliseconds timeout)
+{
+    if (running_)
+        throw exception(exception::reason_id::already_running, "async_connect_server::set_handshake_timeout: attempted to change handshake timeout while server was running");
+
+    handshake_timeout_ = timeout;
+}
+
+void async_connect_server::set_max_frame_size(std::uint32_t max_frame_size)
+{
+    if (running_)
+        throw exception(exception::reason_id::already_running, "async_connect_server::set_max_frame_size: attempted to change frame size limit while server was running");
+
+    if (max_frame_size < sizeof(packet::header))
+        throw exception(exception::reason_id::invalid_limits, "async_connect_server::set_max_frame_size: frame size limit is smaller than a header");
+
+    max_frame_size_ = max_frame_size;
+}
+
+void async_connect_server::set_outbound_limits(std::size_t low, std::size_t high, std::size_t max)
+{
+    if (running_)
+        throw exception(exception::reason_id::already_running, "async_connect_server::set_outbound_limits: attempted to change outbound limits while server was running");
+
+    if (low > high || (max && high > max))
+        throw exception(exception::reason_id::invalid_limits, "async_connect_server::set_outbound_limits: limits must satisfy low <= high <= max");
+
+    write_limits_.low = low;
+    write_limits_.high = high;
+    write_limits_.max = max;
+}
+
+void async_connect_server::set_outbound_budget(std::size_t budget)
+{
+    if (running_)
+        throw exception(exception::reason_id::already_running, "async_connect_server::set_outbound_budget: attempted to change outbound budget while server was running");
+
+    write_limits_.total = budget;
+}
+
+void async_connect_server::set_compression(bool enabled, std::uint32_t min_size)
+{
+    if (running_)
+        throw exception(exception::reason_id::already_running, "async_connect_server::set_compression: attempted to change compression while server was running");
+
+    compression_ = enabled;
+    compression_threshold_ = min_size;
+}
 
-    if (!send_packet_internal(to, packet_data.data(), packet_data.size()))
-        disconnect_client(to);
+void async_connect_server::set_handler_threads(std::uint32_t count, std::size_t max_backlog)
+{
+    if (running_)
+        throw exception(exception::reason_id::already_running, "async_connect_server::set_handler_threads: attempted to change handler threads while server was running");
+
+    handler_threads_ = count;
+    handler_backlog_ = max_backlog;
 }
 
-void async_connect_server::register_callback(std::function<void(async_connect_server *const, const SOCKET, const packet::packet_id, packet::detail::serializer &)> callback_fn)
+void async_connect_server::register_callback(std::function<void(async_connect_server *const, const connection_id, const packet::packet_id, packet::detail::serializer &)> callback_fn)
 {
     if (!callback_fn)
         throw exception(exception::reason_id::null_callback, "async_connect_server::register_callback: no callback given");
@@ -160,21 +322,75 @@ void async_connect_server::register_callback(std::function<void(async_connect_se
     process_callback_ = callback_fn;
 }
 
+void async_connect_server::register_request_callback(std::function<void(async_connect_server *const, const connection_id, const packet::call_id, const packet::packet_id, packet::detail::serializer &)> callback_fn)
+{
+    if (!callback_fn)
+        throw exception(exception::reason_id::null_callback, "async_connect_server::register_request_callback: no callback given");
+
+    request_callback_ = callback_fn;
+}
+
 void async_connect_server::register_stop_callback(std::function<void(async_connect_server *const)> callback_fn)
 {
     on_stop_callback_ = callback_fn;
 }
 
-void async_connect_server::register_connect_callback(std::function<void(async_connect_server *const, const SOCKET)> callback_fn)
+void async_connect_server::register_connect_callback(std::function<void(async_connect_server *const, const connection_id)> callback_fn)
 {
     on_connect_callback = callback_fn;
 }
 
-void async_connect_server::register_disconnect_callback(std::function<void(async_connect_server *const, const SOCKET)> callback_fn)
+void async_connect_server::register_disconnect_callback(std::function<void(async_connect_server *const, const connection_id)> callback_fn)
 {
     on_disconnect_callback_ = callback_fn;
 }
 
+void async_connect_server::register_backpressure_callback(std::function<void(async_connect_server *const, const connection_id, const bool)> callback_fn)
+{
+    on_backpressure_callback_ = callback_fn;
+}
+
+std::uint64_t async_connect_server::get_unknown_packets()
+{
+    return unknown_packets_;
+}
+
+std::uint64_t async_connect_server::get_accepted_connections()
+{
+    return accepted_connections_;
+}
+
+std::uint64_t async_connect_server::get_failed_handshakes()
+{
+    return failed_handshakes_;
+}
+
+std::vector<std::uint8_t> async_connect_server::serialize_frame(packet::base_packet *packet, packet::packet_flags flags, packet::call_id call)
+{
+    // every thread serializes with its own serializer, so sends from different threads never wait on each other
+    thread_local packet::detail::serializer serializer = {};
+
+    auto encoding = packet->get_encoding();
+    std::size_t prefix = flags & packet::flags::fl_response ? sizeof(call) : 0;
+
+    serializer.begin_frame(net::buffer_pool::acquire(0), sizeof(packet::header) + prefix);
+    serializer.set_encoding(encoding);
+
+    packet->serialize_value(serializer);
+
+    auto packet_data = serializer.take_frame();
+
+    packet::header packet_header = construct_packet_header(
+        packet_data.size() - sizeof(packet::header),
+        packet->get_id(),
+        (encoding == packet::enc_compact ? packet::flags::fl_compact : packet::flags::fl_none) | flags);
+
+    memcpy(packet_data.data(), &packet_header, sizeof(packet::header));
+    memcpy(packet_data.data() + sizeof(packet::header), &call, prefix);
+
+    return packet_data;
+}
+
 packet::header async_connect_server::construct_packet_header(packet::packet_length length, packet::packet_id id, packet::packet_flags flags)
 {
     packet::header packet_header = {};
@@ -187,198 +403,1100 @@ packet::header async_connect_server::construct_packet_header(packet::packet_leng
     return packet_header;
 }
 
-bool async_connect_server::perform_handshake(SOCKET with)
+bool async_connect_server::perform_handshake(const packet::header &client_header)
 {
-    packet::header packet_header = construct_packet_header(0, packet::ids::id_handshake, packet::flags::fl_handshake_sv);
+    if (client_header.flags != packet::flags::fl_handshake_cl)
+        return false;
+
+    if (client_header.id != packet::ids::id_handshake)
+        return false;
 
-    auto buffer = reinterpret_cast<char *>(&packet_header);
+    // a client that wants optional features appends their mask to the header
+    if (client_header.length != sizeof(packet::header) && client_header.length != sizeof(packet::header) + sizeof(std::uint32_t))
+        return false;
 
-    if (!send_packet_internal(with, &packet_header, sizeof(packet::header)))
+    if (client_header.magic != PACKET_MAGIC)
         return false;
 
-    int bytes_received = 0;
-    do
+    return true;
+}
+
+std::uint32_t async_connect_server::accepted_features(std::uint32_t offered)
+{
+    std::uint32_t supported = packet::features::ft_none;
+
+    if (compression_)
+        supported |= packet::features::ft_compression;
+
+    return offered & supported;
+}
+
+void async_connect_server::dispatch_packet(connection_id from, packet::packet_id id, packet::packet_flags flags, packet::call_id call, packet::detail::serializer &s)
+{
+    // without a request callback a call is left unanswered and times out on the client
+    if (flags & packet::flags::fl_request)
+    {
+        if (request_callback_)
+            request_callback_(this, from, call, id, s);
+    }
+    else if (!handlers_.dispatch(id, s, this, from))
     {
-        int received = recv(with, buffer + bytes_received, sizeof(packet::header) - bytes_received, 0);
+        if (process_callback_)
+            process_callback_(this, from, id, s);
+        else
+            unknown_packets_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
 
-        if (received <= 0)
-            return false;
+void async_connect_server::run_handler(connection_id from, packet::packet_id id, packet::packet_flags flags, packet::call_id call, std::span<const std::uint8_t> payload)
+{
+    thread_local packet::detail::serializer s = {};
 
-        bytes_received += received;
-    } while (bytes_received < sizeof(packet::header));
+    s.set_max_elements(max_elements_);
+    s.assign_view(payload);
+    s.set_encoding(flags & packet::flags::fl_compact ? packet::enc_compact : packet::enc_fixed);
 
-    if (packet_header.flags != packet::flags::fl_handshake_cl)
-        return false;
+    dispatch_packet(from, id, flags, call, s);
 
-    if (packet_header.id != packet::ids::id_handshake)
-        return false;
+    // reading past the end of the payload means the client sent a malformed packet
+    if (s.has_failed())
+        disconnect_client(from);
+}
 
-    if (packet_header.length != sizeof(packet::header))
-        return false;
+bool async_connect_server::wait_for_packet(connection_id from, const packet_waiter &waiter)
+{
+    auto owner = current_reactor();
 
-    if (packet_header.magic != PACKET_MAGIC)
-        return false;
+    if (owner && owner->owns(from))
+    {
+        owner->add_waiter(from, waiter);
+        return true;
+    }
 
-    return true;
+    owner = find_reactor(from);
+
+    return owner && owner->queue_waiter(from, waiter);
 }
 
-bool async_connect_server::send_packet_internal(SOCKET to, void *const data, const packet::packet_length length)
+bool async_connect_server::queue_and_resume(connection_id to, std::vector<std::uint8_t> &&data, std::coroutine_handle<> handle)
 {
-    std::uint32_t bytes_sent = 0;
-    do
+    auto owner = current_reactor();
+
+    // already on the client's thread, the packet is written right away and there is nothing to wait for
+    if (owner && owner->owns(to))
     {
-        int sent = send(
-            to,
-            reinterpret_cast<char *>(data) + bytes_sent,
-            length - bytes_sent,
-            0);
+        owner->queue_packet(to, std::move(data));
+        return false;
+    }
 
-        if (sent <= 0)
-            return false;
+    owner = find_reactor(to);
 
-        bytes_sent += sent;
-    } while (bytes_sent < length);
+    return owner && owner->queue_and_resume(to, std::move(data), handle);
+}
 
-    return true;
+void async_connect_server::route_packet(connection_id to, std::vector<std::uint8_t> &&data)
+{
+    auto owner = current_reactor();
+
+    if (!owner || !owner->owns(to))
+        owner = find_reactor(to);
+
+    if (owner)
+        owner->queue_packet(to, std::move(data));
 }
 
-void async_connect_server::accept_clients()
+void async_connect_server::route_frame(connection_id to, const net::shared_frame &frame)
 {
-    while (running_)
-    {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    auto owner = current_reactor();
 
-        auto client = accept(server_socket_, nullptr, nullptr);
+    if (!owner || !owner->owns(to))
+        owner = find_reactor(to);
 
-        if (client == INVALID_SOCKET)
-            continue;
+    if (owner)
+        owner->queue_frame(to, frame);
+}
 
-        if (!perform_handshake(client))
-        {
-            shutdown(client, SD_BOTH);
-            closesocket(client);
-            continue;
-        }
+void async_connect_server::broadcast_frame(const net::shared_frame &frame, const std::function<bool(const connection_id)> &filter)
+{
+    // each reactor fans the frame out to its own clients, so the caller posts once per reactor rather than per client
+    for (auto &r : reactors_)
+        r->queue_broadcast(frame, filter);
+}
 
-        std::lock_guard guard(client_mtx_);
-        connected_clients_.push_back(client);
+void async_connect_server::group_frame(std::string_view group, const net::shared_frame &frame)
+{
+    std::shared_lock guard(groups_mtx_);
 
-        if (!on_connect_callback)
-            continue;
+    auto it = groups_.find(group);
+
+    if (it == groups_.end())
+        return;
+
+    for (auto member : it->second)
+        route_frame(member, frame);
+}
 
-        on_connect_callback(this, client);
+void async_connect_server::leave_groups(connection_id who)
+{
+    std::unique_lock guard(groups_mtx_);
+
+    auto it = client_groups_.find(who);
+
+    if (it == client_groups_.end())
+        return;
+
+    for (auto &name : it->second)
+    {
+        auto group = groups_.find(name);
+        group->second.erase(who);
+
+        if (group->second.empty())
+            groups_.erase(group);
     }
+
+    client_groups_.erase(it);
 }
 
-void async_connect_server::process_data()
+async_connect_server::reactor *async_connect_server::find_reactor(connection_id client)
 {
-    while (running_)
+    // the id names its reactor, whether the client is still there is up to the reactor to tell
+    auto index = reactor_of(client);
+    return index < reactors_.size() ? reactors_[index].get() : nullptr;
+}
+
+async_connect_server::reactor *async_connect_server::current_reactor()
+{
+    for (auto &r : reactors_)
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (r->is_current())
+            return r.get();
+    }
 
-        std::lock_guard guard1(client_mtx_);
-        std::lock_guard guard2(process_mtx_);
+    return nullptr;
+}
 
-        for (std::size_t i = 0; i < connected_clients_.size(); i++)
-        {
-            auto client = connected_clients_[i];
-            auto &process_buffer = process_buffers_[client];
+async_connect_server::reactor *async_connect_server::least_loaded_reactor()
+{
+    auto fewer = [](const std::unique_ptr<reactor> &a, const std::unique_ptr<reactor> &b)
+    { return a->get_connection_count() < b->get_connection_count(); };
+
+    if (reactors_.size() == 1)
+        return reactors_.front().get();
 
-            if (process_buffer.size() < sizeof(packet::header))
-                continue;
+    // the first reactor also accepts, so it loses every tie and a busy client there slows accepts as rarely as possible
+    auto least = std::min_element(reactors_.begin() + 1, reactors_.end(), fewer);
 
-            auto header = reinterpret_cast<packet::header *>(process_buffer.data());
+    return fewer(reactors_.front(), *least) ? reactors_.front().get() : least->get();
+}
+
+void async_connect_server::join_reactors()
+{
+    for (auto &r : reactors_)
+    {
+        if (r->thread.joinable())
+            r->thread.join();
+    }
 
-            bool is_disconnect_packet = header->id == packet::ids::id_disconnect && header->flags & packet::flags::fl_disconnect;
+    // handlers still queued run to completion, with the disconnect callbacks of the clients closed on shutdown
+    handler_pool_.stop();
 
-            if (header->magic != PACKET_MAGIC || is_disconnect_packet)
-            {
-                disconnect_client(client);
-                continue;
-            }
+    for (auto &r : reactors_)
+        r->close();
+}
 
-            if (process_buffer.size() < header->length)
-                continue;
+async_connect_server::reactor::reactor(async_connect_server *const server, const std::size_t index) : server_(server), index_(index)
+{
+}
+
+bool async_connect_server::reactor::open()
+{
+    process_serializer_.set_max_elements(server_->max_elements_);
 
-            auto data_start = process_buffer.data() + sizeof(packet::header);
-            std::uint32_t data_length = header->length - sizeof(packet::header);
+    if (!engine_.open())
+        return false;
 
-            serializer.assign_buffer(data_start, data_length);
+    engine_.set_coalescing(server_->coalescing_window_, server_->coalescing_bytes_);
 
-            if (header->id > packet::ids::num_preset_ids)
-                process_callback_(this, client, header->id, serializer);
+    // the budget is shared evenly, each reactor enforces its part over its own clients
+    auto limits = server_->write_limits_;
+    limits.total = limits.total ? std::max<std::size_t>(limits.total / server_->reactors_.size(), 1) : 0;
 
-            if (process_buffers_.find(client) != process_buffers_.end())
-                process_buffer.erase(process_buffer.begin(), process_buffer.begin() + data_length + sizeof(packet::header));
-        }
-    }
+    engine_.set_write_limits(limits);
+
+    return index_ != 0 || engine_.listen(server_->server_socket_);
 }
 
-void async_connect_server::receive_data()
+void async_connect_server::reactor::run()
 {
-    std::vector<std::uint8_t> buffer(buffer_size_);
+    current_ = this;
 
-    while (running_)
+    while (server_->running_)
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        flush_posted();
 
-        std::lock_guard guard(client_mtx_);
-        for (std::size_t i = 0; i < connected_clients_.size(); i++)
-        {
-            auto &client = connected_clients_[i];
+        auto now = std::chrono::steady_clock::now();
 
-            unsigned long available_to_read = 0;
-            ioctlsocket(client, FIONREAD, &available_to_read);
+        deadlines_.advance(now, [this, now](const deadline &expired)
+                           { on_deadline(expired, now); });
 
-            if (!available_to_read)
-                continue;
+        engine_.run_once(*this, deadlines_.next_timeout(now));
+    }
 
-            int bytes_received = recv(client, reinterpret_cast<char *>(buffer.data()), buffer_size_, 0);
+    flush_posted();
 
-            switch (bytes_received)
-            {
-            case -1:
-                disconnect_client(client);
-                break;
-            case 0:
-                break;
-            default:
-                std::lock_guard guard(process_mtx_);
+    while (!handshaking_clients_.empty())
+        close_client(handshaking_clients_.back());
 
-                auto &process_buffer = process_buffers_[client];
-                process_buffer.insert(process_buffer.end(), buffer.begin(), buffer.begin() + bytes_received);
-            }
-        }
+    while (!connected_clients_.empty())
+        close_client(connected_clients_.back());
+
+    // the engine stays open until join_reactors closes it, stop() may still be waking it from another thread
+    if (index_ == 0)
+    {
+        shutdown(server_->server_socket_, SD_BOTH);
+        closesocket(server_->server_socket_);
+        server_->server_socket_ = INVALID_SOCKET;
     }
+}
 
-    for (auto &client : connected_clients_)
-        disconnect_client(client);
+void async_connect_server::reactor::wake()
+{
+    engine_.wake();
 }
 
-void async_connect_server::run_heartbeat()
+void async_connect_server::reactor::signal()
 {
+    // one wake per loop pass is enough no matter how many threads posted in the meantime
+    if (!wake_pending_.exchange(true))
+        engine_.wake();
+}
 
-    auto next = std::chrono::high_resolution_clock::now() + heartbeat_interval_;
-    while (running_)
+void async_connect_server::reactor::close()
+{
+    // clients handed over after this reactor's loop had already exited never got attached
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::lock_guard guard(adopted_mtx_);
 
-        if (std::chrono::high_resolution_clock::now() < next)
-            continue;
+        for (auto client : adopted_clients_)
+            closesocket(client);
 
-        std::lock_guard client_guard(client_mtx_);
-        for (auto it = connected_clients_.begin(); it != connected_clients_.end();)
-        {
-            auto &client = *it;
+        adopted_clients_.clear();
+    }
 
-            auto header = construct_packet_header(0, packet::ids::id_heartbeat, packet::flags::fl_heartbeat);
+    // coroutines still waiting on this reactor are failed rather than left suspended forever
+    posted_packets_.consume([](outbound_packet &&packet)
+                            {
+        if (packet.waiter.complete)
+            packet.waiter.complete(packet.waiter.awaiter, nullptr);
+        else if (packet.resume)
+            packet.resume.resume(); });
 
-            if (!send_packet_internal(client, &header, sizeof(header)))
-                disconnect_client(client);
-            else
-                it++;
-        }
+    engine_.close();
+}
 
-        auto next = std::chrono::high_resolution_clock::now() + heartbeat_interval_;
-    }
-}
\ No newline at end of file
+bool async_connect_server::reactor::is_current()
+{
+    return current_ == this;
+}
+
+bool async_connect_server::reactor::owns(connection_id client)
+{
+    return find_client(client) != nullptr;
+}
+
+std::size_t async_connect_server::reactor::get_connection_count()
+{
+    return connection_count_;
+}
+
+void async_connect_server::reactor::adopt_client(SOCKET client)
+{
+    {
+        std::lock_guard guard(adopted_mtx_);
+        adopted_clients_.push_back(client);
+    }
+
+    signal();
+}
+
+void async_connect_server::reactor::queue_packet(connection_id to, std::vector<std::uint8_t> &&data)
+{
+    // sockets belong to their reactor's thread, other threads hand their packets over to it
+    if (is_current())
+    {
+        write_packet(to, std::move(data));
+        return;
+    }
+
+    if (!server_->running_)
+        return;
+
+    outbound_packet packet = {};
+    packet.to = to;
+    packet.data = std::move(data);
+
+    posted_packets_.push(std::move(packet));
+
+    signal();
+}
+
+void async_connect_server::reactor::queue_frame(connection_id to, const net::shared_frame &frame)
+{
+    if (is_current())
+    {
+        write_frame(to, frame);
+        return;
+    }
+
+    if (!server_->running_)
+        return;
+
+    outbound_packet packet = {};
+    packet.to = to;
+    packet.frame = frame;
+
+    posted_packets_.push(std::move(packet));
+
+    signal();
+}
+
+void async_connect_server::reactor::queue_broadcast(const net::shared_frame &frame, const std::function<bool(const connection_id)> &filter)
+{
+    if (is_current())
+    {
+        write_broadcast(frame, filter);
+        return;
+    }
+
+    if (!server_->running_)
+        return;
+
+    outbound_packet packet = {};
+    packet.frame = frame;
+    packet.filter = filter;
+    packet.broadcast = true;
+
+    posted_packets_.push(std::move(packet));
+
+    signal();
+}
+
+void async_connect_server::reactor::queue_disconnect(connection_id who)
+{
+    outbound_packet disconnect = {};
+    disconnect.to = who;
+    disconnect.disconnect = true;
+
+    posted_packets_.push(std::move(disconnect));
+
+    signal();
+}
+
+void async_connect_server::reactor::queue_release(connection_id who)
+{
+    outbound_packet release = {};
+    release.to = who;
+    release.release = true;
+
+    posted_packets_.push(std::move(release));
+
+    signal();
+}
+
+void async_connect_server::reactor::queue_prune(connection_id who)
+{
+    outbound_packet prune = {};
+    prune.to = who;
+    prune.prune = true;
+
+    posted_packets_.push(std::move(prune));
+
+    signal();
+}
+
+bool async_connect_server::reactor::queue_waiter(connection_id who, const packet_waiter &waiter)
+{
+    if (!server_->running_)
+        return false;
+
+    outbound_packet packet = {};
+    packet.to = who;
+    packet.waiter = waiter;
+
+    posted_packets_.push(std::move(packet));
+
+    signal();
+
+    return true;
+}
+
+bool async_connect_server::reactor::queue_and_resume(connection_id to, std::vector<std::uint8_t> &&data, std::coroutine_handle<> handle)
+{
+    if (!server_->running_)
+        return false;
+
+    outbound_packet packet = {};
+    packet.to = to;
+    packet.data = std::move(data);
+    packet.resume = handle;
+
+    posted_packets_.push(std::move(packet));
+
+    signal();
+
+    return true;
+}
+
+void async_connect_server::reactor::add_waiter(connection_id who, const packet_waiter &waiter)
+{
+    auto state = find_client(who);
+
+    // the client disconnected while the waiter was posted to its reactor
+    if (!state)
+    {
+        waiter.complete(waiter.awaiter, nullptr);
+        return;
+    }
+
+    state->waiters.push_back(waiter);
+}
+
+void async_connect_server::reactor::close_client(connection_id who, bool flush)
+{
+    auto state = find_client(who);
+
+    if (!state)
+        return;
+
+    if (state->handshaking)
+    {
+        auto waiters = take_waiters(who);
+
+        engine_.abort(who.value);
+        forget_client(who);
+        fail_waiters(std::move(waiters));
+        return;
+    }
+
+    // packets queued before the disconnect still go out before the socket is closed, unless the peer stopped reading
+    if (flush)
+        engine_.shutdown(who.value);
+    else
+        engine_.abort(who.value);
+
+    auto waiters = take_waiters(who);
+    auto lane = state->lane;
+
+    forget_client(who);
+
+    // with a handler pool the callback follows the client's last handler on its strand
+    if (server_->on_disconnect_callback_)
+    {
+        if (lane)
+        {
+            lane->strand->post([server = server_, who]
+                               { server->on_disconnect_callback_(server, who); });
+        }
+        else
+            server_->on_disconnect_callback_(server_, who);
+    }
+
+    // resumed last, a coroutine may close other clients
+    fail_waiters(std::move(waiters));
+}
+
+void async_connect_server::reactor::flush_posted()
+{
+    wake_pending_.store(false);
+
+    {
+        std::lock_guard guard(adopted_mtx_);
+        attaching_clients_.swap(adopted_clients_);
+    }
+
+    for (auto client : attaching_clients_)
+        attach_client(client);
+
+    attaching_clients_.clear();
+
+    posted_packets_.consume([this](outbound_packet &&packet)
+                            {
+        if (packet.disconnect)
+            close_client(packet.to);
+        else if (packet.release)
+            release_lane(packet.to);
+        else if (packet.prune)
+        {
+            if (!owns(packet.to))
+                server_->leave_groups(packet.to);
+        }
+        else if (packet.broadcast)
+            write_broadcast(packet.frame, packet.filter);
+        else if (packet.frame)
+            write_frame(packet.to, packet.frame);
+        else if (packet.waiter.complete)
+            add_waiter(packet.to, packet.waiter);
+        else
+        {
+            write_packet(packet.to, std::move(packet.data));
+
+            if (packet.resume)
+                packet.resume.resume();
+        } });
+}
+
+void async_connect_server::reactor::write_packet(connection_id to, std::vector<std::uint8_t> &&data)
+{
+    if (compresses(to, data.size()))
+    {
+        auto compressed = net::buffer_pool::acquire(0);
+
+        if (packet::detail::compress_frame(data.data(), data.size(), compressed))
+            data.swap(compressed);
+
+        net::buffer_pool::release(std::move(compressed));
+    }
+
+    engine_.write(to.value, std::move(data));
+}
+
+void async_connect_server::reactor::write_frame(connection_id to, const net::shared_frame &frame)
+{
+    if (compresses(to, frame->size()))
+        engine_.write(to.value, compressed_frame(frame));
+    else
+        engine_.write(to.value, frame);
+}
+
+void async_connect_server::reactor::write_broadcast(const net::shared_frame &frame, const std::function<bool(const connection_id)> &filter)
+{
+    // the filter may disconnect clients, which changes connected_clients_ underneath the loop
+    broadcast_clients_.assign(connected_clients_.begin(), connected_clients_.end());
+
+    for (auto client : broadcast_clients_)
+    {
+        if (!filter || filter(client))
+            write_frame(client, frame);
+    }
+}
+
+bool async_connect_server::reactor::compresses(connection_id to, std::size_t length)
+{
+    if (!server_->compression_ || length < sizeof(packet::header) + server_->compression_threshold_)
+        return false;
+
+    auto state = find_client(to);
+    return state && state->compression;
+}
+
+const net::shared_frame &async_connect_server::reactor::compressed_frame(const net::shared_frame &frame)
+{
+    if (frame == compressed_source_)
+        return compressed_result_;
+
+    std::vector<std::uint8_t> compressed = {};
+
+    // a frame that does not shrink is sent as it is, to this and every further recipient
+    if (packet::detail::compress_frame(frame->data(), frame->size(), compressed))
+        compressed_result_ = std::make_shared<const std::vector<std::uint8_t>>(std::move(compressed));
+    else
+        compressed_result_ = frame;
+
+    compressed_source_ = frame;
+
+    return compressed_result_;
+}
+
+void async_connect_server::reactor::complete_handshake(connection_id client, std::uint32_t offered)
+{
+    auto accepted = server_->accepted_features(offered);
+
+    find_client(client)->compression = accepted & packet::features::ft_compression;
+
+    // the server's header already went out on attach, a client that offered features is answered with a second one
+    auto header = server_->construct_packet_header(sizeof(accepted), packet::ids::id_handshake, packet::flags::fl_handshake_sv);
+
+    auto answer = net::buffer_pool::acquire(sizeof(header) + sizeof(accepted));
+    memcpy(answer.data(), &header, sizeof(header));
+    memcpy(answer.data() + sizeof(header), &accepted, sizeof(accepted));
+
+    engine_.write(client.value, std::move(answer));
+}
+
+bool async_connect_server::reactor::complete_read(connection_id client, packet::packet_id id)
+{
+    auto &waiters = find_client(client)->waiters;
+
+    auto waiter = std::find_if(waiters.begin(), waiters.end(), [id](const packet_waiter &w)
+                               { return w.id == id; });
+
+    if (waiter == waiters.end())
+        return false;
+
+    auto reader = *waiter;
+    waiters.erase(waiter);
+
+    reader.complete(reader.awaiter, &process_serializer_);
+    return true;
+}
+
+std::vector<async_connect_server::packet_waiter> async_connect_server::reactor::take_waiters(connection_id client)
+{
+    auto state = find_client(client);
+
+    if (!state)
+        return {};
+
+    return std::move(state->waiters);
+}
+
+void async_connect_server::reactor::fail_waiters(std::vector<packet_waiter> &&waiters)
+{
+    for (auto &waiter : waiters)
+        waiter.complete(waiter.awaiter, nullptr);
+}
+
+void async_connect_server::reactor::hand_off(connection_id client, packet::packet_id id, packet::packet_flags flags, packet::call_id call, std::span<const std::uint8_t> payload)
+{
+    auto &state = *find_client(client);
+    auto lane = state.lane;
+
+    // the payload points into the receive buffer, which is reused as soon as this returns
+    auto data = net::buffer_pool::acquire(payload.size());
+
+    if (!payload.empty())
+        memcpy(data.data(), payload.data(), payload.size());
+
+    auto size = data.size();
+    auto limit = server_->handler_backlog_;
+
+    lane->backlog += size;
+
+    lane->strand->post([server = server_, owner = this, lane, client, id, flags, call, size, limit, data = std::move(data)]() mutable
+                       {
+        server->run_handler(client, id, flags, call, data);
+        net::buffer_pool::release(std::move(data));
+
+        // only the handler that brings the backlog down to half the limit wakes the reactor
+        auto before = lane->backlog.fetch_sub(size);
+
+        if (limit && before > limit / 2 && before - size <= limit / 2)
+            owner->queue_release(client); });
+
+    // a client whose handlers fall behind is not read from until they caught up, as with a peer that stopped reading
+    if (limit && !state.lane_held && lane->backlog > limit)
+    {
+        state.lane_held = true;
+        engine_.hold_reading(client.value, true);
+    }
+}
+
+void async_connect_server::reactor::release_lane(connection_id client)
+{
+    auto state = find_client(client);
+
+    if (!state || !state->lane_held || state->lane->backlog > server_->handler_backlog_ / 2)
+        return;
+
+    state->lane_held = false;
+    engine_.hold_reading(client.value, false);
+}
+
+void async_connect_server::reactor::attach_client(SOCKET socket)
+{
+    auto slot = clients_.insert();
+    auto client = make_id(index_, slot.slot, slot.generation);
+
+    if (!engine_.attach(socket, client.value))
+    {
+        clients_.erase(slot);
+        closesocket(socket);
+        connection_count_--;
+        return;
+    }
+
+    auto &state = *clients_.find(slot);
+    state.handshaking = true;
+    state.position = handshaking_clients_.size();
+    state.buffer.reserve(server_->buffer_size_);
+
+    handshaking_clients_.push_back(client);
+
+    if (server_->handler_threads_)
+        state.lane = std::make_shared<handler_lane>(server_->handler_pool_);
+
+    // the client's half of the handshake is validated once its header has been received
+    auto header = server_->construct_packet_header(0, packet::ids::id_handshake, packet::flags::fl_handshake_sv);
+    auto header_bytes = reinterpret_cast<std::uint8_t *>(&header);
+
+    engine_.write(client.value, std::vector<std::uint8_t>(header_bytes, header_bytes + sizeof(header)));
+
+    // a peer that never answers would otherwise hold its slot until the server stops
+    if (server_->handshake_timeout_.count())
+        deadlines_.schedule(std::chrono::steady_clock::now() + server_->handshake_timeout_, {client, dl_handshake});
+}
+
+async_connect_server::reactor::client_table::handle async_connect_server::reactor::slot_of(connection_id client)
+{
+    return {static_cast<std::uint32_t>(client.value), static_cast<std::uint32_t>(client.value >> 40)};
+}
+
+std::size_t async_connect_server::reactor::missing_bytes(const packet::detail::frame_buffer &buffer)
+{
+    if (buffer.size() < sizeof(packet::header))
+        return 0;
+
+    packet::header header = {};
+    memcpy(&header, buffer.data(), sizeof(header));
+
+    // process_data has already refused a frame whose header is malformed or over the limit
+    return header.length > buffer.size() ? header.length - buffer.size() : 0;
+}
+
+async_connect_server::reactor::client_state *async_connect_server::reactor::find_client(connection_id client)
+{
+    return reactor_of(client) == index_ ? clients_.find(slot_of(client)) : nullptr;
+}
+
+void async_connect_server::reactor::unlist_client(client_state &state)
+{
+    auto &list = state.handshaking ? handshaking_clients_ : connected_clients_;
+
+    // the last client of the list takes the place of the one leaving
+    auto last = list.back();
+    list[state.position] = last;
+    list.pop_back();
+
+    if (auto moved = find_client(last); moved != &state)
+        moved->position = state.position;
+}
+
+void async_connect_server::reactor::forget_client(connection_id client)
+{
+    auto state = find_client(client);
+
+    if (!state)
+        return;
+
+    unlist_client(*state);
+
+    // a callback disconnecting its own client must still be able to read the packet it was handed
+    if (client == dispatching_client_)
+        released_buffer_ = std::move(state->buffer);
+
+    clients_.erase(slot_of(client));
+    connection_count_--;
+
+    server_->leave_groups(client);
+}
+
+std::size_t async_connect_server::reactor::process_data(connection_id client, const std::uint8_t *data, std::size_t length)
+{
+    std::size_t processed = 0;
+
+    while (length - processed >= sizeof(packet::header))
+    {
+        packet::header header = {};
+        memcpy(&header, data + processed, sizeof(header));
+
+        if (find_client(client)->handshaking)
+        {
+            if (!server_->perform_handshake(header))
+            {
+                server_->failed_handshakes_.fetch_add(1, std::memory_order_relaxed);
+                close_client(client);
+                return processed;
+            }
+
+            if (length - processed < header.length)
+                break;
+
+            if (header.length > sizeof(packet::header))
+            {
+                std::uint32_t offered = 0;
+                memcpy(&offered, data + processed + sizeof(packet::header), sizeof(offered));
+
+                complete_handshake(client, offered);
+            }
+
+            processed += header.length;
+
+            auto &state = *find_client(client);
+
+            unlist_client(state);
+            state.handshaking = false;
+            state.position = connected_clients_.size();
+
+            connected_clients_.push_back(client);
+
+            start_deadlines(client);
+
+            if (server_->on_connect_callback)
+                server_->on_connect_callback(server_, client);
+
+            if (!owns(client))
+                return processed;
+
+            continue;
+        }
+
+        bool is_disconnect_packet = header.id == packet::ids::id_disconnect && header.flags & packet::flags::fl_disconnect;
+
+        // an oversized frame is refused from its header, before any of it is buffered
+        if (header.magic != PACKET_MAGIC || header.length < sizeof(packet::header) || header.length > server_->max_frame_size_ || is_disconnect_packet)
+        {
+            close_client(client);
+            return processed;
+        }
+
+        if (length - processed < header.length)
+            break;
+
+        auto payload = std::span(data + processed + sizeof(packet::header), header.length - sizeof(packet::header));
+
+        // only a client that negotiated compression may send compressed frames, and they may not inflate past the limit
+        if (header.flags & packet::flags::fl_compressed)
+        {
+            if (!find_client(client)->compression || !packet::detail::decompress_payload(payload.data(), payload.size(), server_->max_frame_size_ - sizeof(packet::header), inflated_))
+            {
+                close_client(client);
+                return processed;
+            }
+
+            payload = std::span(inflated_.data(), inflated_.size());
+        }
+
+        packet::call_id call = 0;
+        bool is_request = header.flags & packet::flags::fl_request;
+
+        if (is_request)
+        {
+            if (payload.size() < sizeof(call))
+            {
+                close_client(client);
+                return processed;
+            }
+
+            memcpy(&call, payload.data(), sizeof(call));
+            payload = payload.subspan(sizeof(call));
+        }
+
+        process_serializer_.assign_view(payload);
+        process_serializer_.set_encoding(header.flags & packet::flags::fl_compact ? packet::enc_compact : packet::enc_fixed);
+
+        // coroutines waiting for the packet resume right here, anything else goes to the handler pool if there is one
+        if (header.id > packet::ids::num_preset_ids && (is_request || !complete_read(client, header.id)))
+        {
+            if (server_->handler_threads_)
+                hand_off(client, header.id, header.flags, call, payload);
+            else
+                server_->dispatch_packet(client, header.id, header.flags, call, process_serializer_);
+        }
+
+        processed += header.length;
+
+        // the callback may have disconnected the client, which releases the buffer data points into
+        if (!owns(client))
+            return processed;
+
+        // reading past the end of the payload means the client sent a malformed packet
+        if (process_serializer_.has_failed())
+        {
+            close_client(client);
+            return processed;
+        }
+    }
+
+    return processed;
+}
+
+void async_connect_server::reactor::start_deadlines(connection_id client)
+{
+    auto &state = *find_client(client);
+    auto now = std::chrono::steady_clock::now();
+
+    state.last_receive = now;
+
+    // every client runs on its own schedule from the moment it connected, so heartbeats are spread out over the interval
+    deadlines_.schedule(now + server_->heartbeat_interval_, {client, dl_heartbeat});
+
+    if (server_->idle_timeout_.count())
+        deadlines_.schedule(now + server_->idle_timeout_, {client, dl_idle});
+
+    if (server_->write_timeout_.count())
+        deadlines_.schedule(now + server_->write_timeout_, {client, dl_write_stall});
+}
+
+void async_connect_server::reactor::on_deadline(const deadline &expired, std::chrono::steady_clock::time_point now)
+{
+    auto found = find_client(expired.client);
+
+    if (!found)
+        return;
+
+    auto &state = *found;
+    std::uint64_t queued = 0, sent = 0;
+
+    if (!engine_.get_progress(expired.client.value, queued, sent))
+        return;
+
+    switch (expired.kind)
+    {
+    case dl_heartbeat:
+    {
+        // anything else sent during the interval already told the client the connection is alive
+        if (queued == state.heartbeat_mark)
+        {
+            auto header = server_->construct_packet_header(0, packet::ids::id_heartbeat, packet::flags::fl_heartbeat);
+
+            auto heartbeat = net::buffer_pool::acquire(sizeof(header));
+            memcpy(heartbeat.data(), &header, sizeof(header));
+
+            engine_.write(expired.client.value, std::move(heartbeat));
+            queued += sizeof(header);
+        }
+
+        state.heartbeat_mark = queued;
+        deadlines_.schedule(now + server_->heartbeat_interval_, expired);
+
+        // memory a burst of large frames left behind is given back over the following intervals
+        state.buffer.trim(server_->buffer_size_);
+        break;
+    }
+    case dl_idle:
+    {
+        auto idle_until = state.last_receive + server_->idle_timeout_;
+
+        if (now >= idle_until)
+        {
+            close_client(expired.client, false);
+            break;
+        }
+
+        deadlines_.schedule(idle_until, expired);
+        break;
+    }
+    case dl_write_stall:
+    {
+        // data was waiting the whole timeout and none of it went out
+        if (queued != sent && sent == state.stall_mark)
+        {
+            close_client(expired.client, false);
+            break;
+        }
+
+        state.stall_mark = sent;
+        deadlines_.schedule(now + server_->write_timeout_, expired);
+        break;
+    }
+    case dl_handshake:
+    {
+        if (state.handshaking)
+        {
+            server_->failed_handshakes_.fetch_add(1, std::memory_order_relaxed);
+            close_client(expired.client, false);
+        }
+
+        break;
+    }
+    }
+}
+
+void async_connect_server::reactor::on_accept(SOCKET client)
+{
+    int no_delay = 1;
+    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char *>(&no_delay), sizeof(no_delay));
+
+    server_->accepted_connections_.fetch_add(1, std::memory_order_relaxed);
+
+    auto target = server_->least_loaded_reactor();
+    target->connection_count_++;
+
+    if (target == this)
+        attach_client(client);
+    else
+        target->adopt_client(client);
+}
+
+void async_connect_server::reactor::on_receive(std::uint64_t token, const std::uint8_t *data, std::size_t length)
+{
+    auto client = connection_id{token};
+    auto state = find_client(client);
+
+    if (!state)
+        return;
+
+    if (server_->idle_timeout_.count())
+        state->last_receive = std::chrono::steady_clock::now();
+
+    dispatching_client_ = client;
+
+    // complete frames are dispatched straight out of the engine's buffer, only a trailing partial frame is kept
+    if (state->buffer.empty())
+    {
+        auto processed = process_data(client, data, length);
+
+        state = find_client(client);
+
+        if (state)
+        {
+            state->buffer.append(data + processed, length - processed);
+            state->missing = missing_bytes(state->buffer);
+        }
+        else
+            released_buffer_ = {};
+
+        dispatching_client_ = {};
+        return;
+    }
+
+    // the rest of a large frame was received in place and only needs to be taken into the buffer
+    if (data == state->buffer.tail())
+        state->buffer.commit(length);
+    else
+        state->buffer.append(data, length);
+
+    auto processed = process_data(client, state->buffer.data(), state->buffer.size());
+
+    state = find_client(client);
+
+    if (state)
+    {
+        state->buffer.consume(processed);
+        state->missing = missing_bytes(state->buffer);
+    }
+    else
+        released_buffer_ = {};
+
+    dispatching_client_ = {};
+}
+
+std::span<std::uint8_t> async_connect_server::reactor::receive_space(std::uint64_t token)
+{
+    auto state = find_client(connection_id{token});
+
+    // the body of a large frame is received right into the buffer. its room grows with what has arrived rather than
+    // with what the header announces, so a header alone cannot make the reactor allocate the whole frame
+    if (!state || state->missing < server_->large_frame_size_)
+        return {};
+
+    auto room = std::min(state->missing, std::max(server_->large_frame_size_, state->buffer.size()));
+    return {state->buffer.prepare(room), room};
+}
+
+void async_connect_server::reactor::on_close(std::uint64_t token)
+{
+    close_client(connection_id{token});
+}
+
+void async_connect_server::reactor::on_congestion(std::uint64_t token, bool congested)
+{
+    auto client = connection_id{token};
+    auto state = find_client(client);
+
+    if (!state || state->handshaking)
+        return;
+
+    if (server_->on_backpressure_callback_)
+        server_->on_backpressure_callback_(server_, client, congested);
+}
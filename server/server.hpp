@@ -1,22 +1,49 @@
 #ifndef SERVER_H
 #define SERVER_H
 
-#pragma region windows_includes
-
-#ifdef _WIN32
-    #include <WinSock2.h>
-    #include <WS2tcpip.h>
-    #pragma comment(lib, "ws2_32.lib")
-#else
-    #error Currently only Windows is supported.
-#endif
-
 #include <functional>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <thread>
+#include "../net/buffer_pool.hpp"
+#include "../net/io_engine.hpp"
+#include "../net/mpsc_queue.hpp"
+#include "../net/slot_table.hpp"
+#include "../net/task.hpp"
+#include "../net/timer_wheel.hpp"
+#include "../net/worker_pool.hpp"
+#include "../packet/compression.hpp"
+#include "../packet/dispatch.hpp"
 #include "../packet/packet.hpp"
 
+namespace acc
+{
+    // names a connection for as long as the server runs. unlike a socket descriptor it is never handed to another
+    // client, so a handle kept past its disconnect refers to nothing rather than to whoever connected next
+    struct connection_id
+    {
+        std::uint64_t value = 0;
+
+        bool operator==(const connection_id &) const = default;
+    };
+}
+
+template <>
+struct std::hash<acc::connection_id>
+{
+    std::size_t operator()(const acc::connection_id &id) const noexcept
+    {
+        return std::hash<std::uint64_t>{}(id.value);
+    }
+};
+
 namespace acc
 {
     class async_connect_server
@@ -26,52 +53,411 @@ namespace acc
         ~async_connect_server();
         void start(std::string_view port);
         void stop();
-        void disconnect_client(SOCKET who);
+        void disconnect_client(connection_id who);
         bool is_running();
-        void send_packet(SOCKET to, packet::base_packet *packet);
-        void register_callback(std::function<void(async_connect_server *const, const SOCKET, const packet::packet_id, packet::detail::serializer &)> callback_fn);
+        void send_packet(connection_id to, packet::base_packet *packet);
+
+        template <packet::schema_packet T>
+        void send_packet(connection_id to, const T &packet)
+        {
+            route_packet(to, encode_frame(packet));
+        }
+
+        // answers a call received through the request callback, from any thread and at any later time
+        void respond(connection_id to, packet::call_id call, packet::base_packet *packet);
+
+        template <packet::schema_packet T>
+        void respond(connection_id to, packet::call_id call, const T &packet)
+        {
+            route_packet(to, encode_frame(packet, packet::flags::fl_response, call));
+        }
+
+        // the packet is serialized once and the same frame is queued to every recipient
+        void broadcast(packet::base_packet *packet, std::function<bool(const connection_id)> filter = {});
+        void send_to_group(std::string_view group, packet::base_packet *packet);
+
+        template <packet::schema_packet T>
+        void broadcast(const T &packet, std::function<bool(const connection_id)> filter = {})
+        {
+            broadcast_frame(std::make_shared<const std::vector<std::uint8_t>>(encode_frame(packet)), filter);
+        }
+
+        template <packet::schema_packet T>
+        void send_to_group(std::string_view group, const T &packet)
+        {
+            group_frame(group, std::make_shared<const std::vector<std::uint8_t>>(encode_frame(packet)));
+        }
+
+        // resumes on the client's reactor thread with its next packet of id T that nobody else waited for first, or
+        // with nothing once the client disconnected. packets nobody waits for go to the callback
+        template <packet::schema_packet T>
+        class read_awaitable
+        {
+        public:
+            read_awaitable(async_connect_server *const server, connection_id from) : server_(server), from_(from) {}
+
+            bool await_ready()
+            {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                handle_ = handle;
+                return server_->wait_for_packet(from_, {T::id, this, &read_awaitable::complete});
+            }
+
+            std::optional<T> await_resume()
+            {
+                return std::move(result_);
+            }
+
+        private:
+            static void complete(void *awaiter, packet::detail::serializer *const s)
+            {
+                auto self = static_cast<read_awaitable *>(awaiter);
+                T packet = {};
+
+                if (s && packet::decode(*s, packet))
+                    self->result_ = std::move(packet);
+
+                self->handle_.resume();
+            }
+
+            async_connect_server *const server_;
+            const connection_id from_;
+            std::coroutine_handle<> handle_ = nullptr;
+            std::optional<T> result_ = std::nullopt;
+        };
+
+        // queues the packet and continues on the client's reactor thread
+        class send_awaitable
+        {
+        public:
+            send_awaitable(async_connect_server *const server, connection_id to, std::vector<std::uint8_t> &&frame) : server_(server), to_(to), frame_(std::move(frame)) {}
+
+            bool await_ready()
+            {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                return server_->queue_and_resume(to_, std::move(frame_), handle);
+            }
+
+            void await_resume() {}
+
+        private:
+            async_connect_server *const server_;
+            const connection_id to_;
+            std::vector<std::uint8_t> frame_ = {};
+        };
+
+        template <packet::schema_packet T>
+        read_awaitable<T> async_read(connection_id from)
+        {
+            return read_awaitable<T>(this, from);
+        }
+
+        template <packet::schema_packet T>
+        send_awaitable async_send(connection_id to, const T &packet)
+        {
+            return send_awaitable(this, to, encode_frame(packet));
+        }
+
+        void join_group(connection_id who, std::string_view group);
+        void leave_group(connection_id who, std::string_view group);
+
+        void set_reactor_count(std::uint32_t count);
+        void set_max_elements(std::uint32_t max_elements);
+        void set_coalescing(std::chrono::microseconds window, std::size_t min_bytes);
+        void set_idle_timeout(std::chrono::milliseconds timeout);
+        void set_write_timeout(std::chrono::milliseconds timeout);
+        void set_handshake_timeout(std::chrono::milliseconds timeout);
+        void set_max_frame_size(std::uint32_t max_frame_size);
+        void set_outbound_limits(std::size_t low, std::size_t high, std::size_t max);
+        void set_outbound_budget(std::size_t budget);
+        void set_compression(bool enabled, std::uint32_t min_size);
+        void set_handler_threads(std::uint32_t count, std::size_t max_backlog);
+        void register_callback(std::function<void(async_connect_server *const, const connection_id, const packet::packet_id, packet::detail::serializer &)> callback_fn);
+        void register_request_callback(std::function<void(async_connect_server *const, const connection_id, const packet::call_id, const packet::packet_id, packet::detail::serializer &)> callback_fn);
         void register_stop_callback(std::function<void(async_connect_server *const)> callback_fn);
-        void register_connect_callback(std::function<void(async_connect_server *const, const SOCKET)> callback_fn);
-        void register_disconnect_callback(std::function<void(async_connect_server *const, const SOCKET)> callback_fn);
+        void register_connect_callback(std::function<void(async_connect_server *const, const connection_id)> callback_fn);
+        void register_disconnect_callback(std::function<void(async_connect_server *const, const connection_id)> callback_fn);
+        void register_backpressure_callback(std::function<void(async_connect_server *const, const connection_id, const bool)> callback_fn);
+
+        // handler_fn is called as handler_fn(server, from, packet) for every packet::T received
+        template <packet::schema_packet T, typename F>
+        void register_handler(F &&handler_fn)
+        {
+            handlers_.template add<T>(std::forward<F>(handler_fn));
+        }
+
+        std::uint64_t get_unknown_packets();
+        std::uint64_t get_accepted_connections();
+        std::uint64_t get_failed_handshakes();
 
     private:
 #ifdef _WIN32
         WSADATA wsa_data_ = {};
 #endif
 
+        // a connection_id holds the client's slot in its reactor's connection table in bits 0-31, the reactor in bits
+        // 32-39 and the slot's generation in bits 40-62. the top bit stays clear, the engines reserve tokens above it
+        static constexpr unsigned int id_generation_bits = 23;
+        static constexpr std::uint32_t max_reactors = 256;
+
+        static connection_id make_id(std::size_t reactor, std::uint32_t slot, std::uint32_t generation)
+        {
+            return {static_cast<std::uint64_t>(generation) << 40 | static_cast<std::uint64_t>(reactor) << 32 | slot};
+        }
+
+        static std::size_t reactor_of(connection_id id)
+        {
+            return static_cast<std::size_t>(id.value >> 32 & 0xff);
+        }
+
+        // a coroutine waiting for a packet, serializer is nullptr once the client disconnected
+        struct packet_waiter
+        {
+            packet::packet_id id = packet::ids::id_none;
+            void *awaiter = nullptr;
+            void (*complete)(void *awaiter, packet::detail::serializer *const s) = nullptr;
+        };
+
+        struct outbound_packet
+        {
+            connection_id to = {};
+            std::vector<std::uint8_t> data = {};
+            net::shared_frame frame = nullptr;
+            std::function<bool(const connection_id)> filter = {};
+            packet_waiter waiter = {};
+            std::coroutine_handle<> resume = nullptr;
+            bool disconnect = false, broadcast = false, release = false, prune = false;
+        };
+
+        // a client's packets handed to the handler pool run in order on its strand, backlog counts their payload bytes
+        struct handler_lane
+        {
+            explicit handler_lane(net::worker_pool &pool) : strand(std::make_shared<net::strand>(pool)) {}
+
+            std::shared_ptr<net::strand> strand = nullptr;
+            std::atomic<std::size_t> backlog = 0;
+        };
+
+        struct string_hash
+        {
+            using is_transparent = void;
+
+            std::size_t operator()(std::string_view value) const
+            {
+                return std::hash<std::string_view>{}(value);
+            }
+        };
+
+        // owns a disjoint set of clients, all of their I/O and all of their callbacks run on the reactor's thread
+        class reactor : private net::io_handler
+        {
+        public:
+            reactor(async_connect_server *const server, const std::size_t index);
+
+            bool open();
+            void run();
+            void wake();
+            void close();
+
+            bool is_current();
+            bool owns(connection_id client);
+            std::size_t get_connection_count();
+
+            void adopt_client(SOCKET client);
+            void queue_packet(connection_id to, std::vector<std::uint8_t> &&data);
+            void queue_frame(connection_id to, const net::shared_frame &frame);
+            void queue_broadcast(const net::shared_frame &frame, const std::function<bool(const connection_id)> &filter);
+            void queue_disconnect(connection_id who);
+            void queue_release(connection_id who);
+            void queue_prune(connection_id who);
+            bool queue_waiter(connection_id who, const packet_waiter &waiter);
+            bool queue_and_resume(connection_id to, std::vector<std::uint8_t> &&data, std::coroutine_handle<> handle);
+            void add_waiter(connection_id who, const packet_waiter &waiter);
+            void close_client(connection_id who, bool flush = true);
+
+            std::thread thread = {};
+
+        private:
+            enum deadline_kind : std::uint8_t
+            {
+                dl_heartbeat = 0,
+                dl_idle,
+                dl_write_stall,
+                dl_handshake
+            };
+
+            // timers are not cancelled, one whose client is gone is dropped when it fires
+            struct deadline
+            {
+                connection_id client = {};
+                deadline_kind kind = dl_heartbeat;
+            };
+
+            // everything a reactor keeps about one client, in a single slot of its connection table
+            struct client_state
+            {
+                bool handshaking = false;
+                std::size_t position = 0;
+                packet::detail::frame_buffer buffer = {};
+                std::size_t missing = 0;
+                std::chrono::steady_clock::time_point last_receive = {};
+                std::uint64_t heartbeat_mark = 0, stall_mark = 0;
+                bool compression = false;
+                std::vector<packet_waiter> waiters = {};
+                std::shared_ptr<handler_lane> lane = nullptr;
+                bool lane_held = false;
+            };
+
+            typedef net::slot_table<client_state, id_generation_bits> client_table;
+
+            static client_table::handle slot_of(connection_id client);
+            static std::size_t missing_bytes(const packet::detail::frame_buffer &buffer);
+
+            void signal();
+            void flush_posted();
+            void write_packet(connection_id to, std::vector<std::uint8_t> &&data);
+            void write_frame(connection_id to, const net::shared_frame &frame);
+            void write_broadcast(const net::shared_frame &frame, const std::function<bool(const connection_id)> &filter);
+            bool compresses(connection_id to, std::size_t length);
+            const net::shared_frame &compressed_frame(const net::shared_frame &frame);
+            void complete_handshake(connection_id client, std::uint32_t offered);
+            bool complete_read(connection_id client, packet::packet_id id);
+            std::vector<packet_waiter> take_waiters(connection_id client);
+            void fail_waiters(std::vector<packet_waiter> &&waiters);
+            void hand_off(connection_id client, packet::packet_id id, packet::packet_flags flags, packet::call_id call, std::span<const std::uint8_t> payload);
+            void release_lane(connection_id client);
+            void attach_client(SOCKET client);
+            client_state *find_client(connection_id client);
+            void unlist_client(client_state &state);
+            void forget_client(connection_id client);
+            std::size_t process_data(connection_id client, const std::uint8_t *data, std::size_t length);
+            void start_deadlines(connection_id client);
+            void on_deadline(const deadline &expired, std::chrono::steady_clock::time_point now);
+
+            void on_accept(SOCKET client) override;
+            void on_receive(std::uint64_t token, const std::uint8_t *data, std::size_t length) override;
+            std::span<std::uint8_t> receive_space(std::uint64_t token) override;
+            void on_close(std::uint64_t token) override;
+            void on_congestion(std::uint64_t token, bool congested) override;
+
+            static thread_local reactor *current_;
+
+            async_connect_server *const server_;
+            const std::size_t index_;
+
+            net::io_engine engine_ = {};
+
+            net::mpsc_queue<outbound_packet> posted_packets_ = {};
+            std::atomic_bool wake_pending_ = false;
+
+            std::mutex adopted_mtx_ = {};
+            std::vector<SOCKET> adopted_clients_ = {}, attaching_clients_ = {};
+
+            std::atomic<std::size_t> connection_count_ = 0;
+
+            // a client's position in whichever of the two lists it is on is kept in its state, so it leaves in O(1)
+            std::vector<connection_id> handshaking_clients_ = {}, connected_clients_ = {}, broadcast_clients_ = {};
+            client_table clients_ = {};
+
+            net::timer_wheel<deadline> deadlines_ = {};
+
+            connection_id dispatching_client_ = {};
+            packet::detail::frame_buffer released_buffer_ = {};
+
+            // a frame sent to many clients is compressed once, the last result is kept for the next recipient
+            net::shared_frame compressed_source_ = nullptr, compressed_result_ = nullptr;
+            std::vector<std::uint8_t> inflated_ = {};
+
+            packet::detail::serializer process_serializer_ = {};
+        };
+
         packet::header construct_packet_header(packet::packet_length length, packet::packet_id id, packet::packet_flags flags);
 
-        bool perform_handshake(SOCKET with);
-        bool send_packet_internal(SOCKET to, void *const data, const packet::packet_length length);
-        void accept_clients();
-        void process_data();
-        void receive_data();
-        void run_heartbeat();
+        // a response carries the call it answers in front of its payload
+        template <packet::schema_packet T>
+        std::vector<std::uint8_t> encode_frame(const T &packet, packet::packet_flags flags = packet::flags::fl_none, packet::call_id call = 0)
+        {
+            std::size_t prefix = flags & packet::flags::fl_response ? sizeof(call) : 0;
+
+            auto packet_data = net::buffer_pool::acquire(sizeof(packet::header) + prefix + packet::encoded_size(packet));
+
+            auto packet_header = construct_packet_header(packet_data.size() - sizeof(packet::header), T::id, packet::encoding_flags<T>() | flags);
+            memcpy(packet_data.data(), &packet_header, sizeof(packet::header));
+            memcpy(packet_data.data() + sizeof(packet::header), &call, prefix);
+
+            packet::encode(packet, packet_data.data() + sizeof(packet::header) + prefix);
 
-        bool running_ = false;
+            return packet_data;
+        }
+
+        std::vector<std::uint8_t> serialize_frame(packet::base_packet *packet, packet::packet_flags flags = packet::flags::fl_none, packet::call_id call = 0);
+
+        bool perform_handshake(const packet::header &client_header);
+        std::uint32_t accepted_features(std::uint32_t offered);
+        bool wait_for_packet(connection_id from, const packet_waiter &waiter);
+        void dispatch_packet(connection_id from, packet::packet_id id, packet::packet_flags flags, packet::call_id call, packet::detail::serializer &s);
+        void run_handler(connection_id from, packet::packet_id id, packet::packet_flags flags, packet::call_id call, std::span<const std::uint8_t> payload);
+        bool queue_and_resume(connection_id to, std::vector<std::uint8_t> &&data, std::coroutine_handle<> handle);
+        void route_packet(connection_id to, std::vector<std::uint8_t> &&data);
+        void route_frame(connection_id to, const net::shared_frame &frame);
+        void broadcast_frame(const net::shared_frame &frame, const std::function<bool(const connection_id)> &filter);
+        void group_frame(std::string_view group, const net::shared_frame &frame);
+        void leave_groups(connection_id who);
+        reactor *find_reactor(connection_id client);
+        reactor *current_reactor();
+        reactor *least_loaded_reactor();
+        void join_reactors();
+
+        std::atomic_bool running_ = false;
 
         const std::uint32_t buffer_size_ = PACKET_BUFFER_SIZE;
+        const std::size_t large_frame_size_ = 64 * 1024;
         const std::chrono::duration<long long> heartbeat_interval_ = std::chrono::seconds(5);
 
-        SOCKET server_socket_ = 0;
+        std::uint32_t reactor_count_ = 1;
+        std::uint32_t max_elements_ = UINT32_MAX;
 
-        std::mutex send_mtx_ = {}, disconnect_mtx_ = {};
+        std::chrono::microseconds coalescing_window_ = {};
+        std::size_t coalescing_bytes_ = 0;
 
-        std::recursive_mutex client_mtx_ = {}, process_mtx_ = {};
+        std::chrono::milliseconds idle_timeout_ = {}, write_timeout_ = {};
+        std::chrono::milliseconds handshake_timeout_ = std::chrono::seconds(5);
 
-        std::vector<SOCKET> clients_to_disconnect_ = {};
+        std::uint32_t max_frame_size_ = PACKET_MAX_FRAME_SIZE;
+        net::write_limits write_limits_ = {};
 
-        std::vector<SOCKET> connected_clients_ = {};
-        std::unordered_map<SOCKET, std::vector<std::uint8_t>> process_buffers_ = {};
+        bool compression_ = false;
+        std::uint32_t compression_threshold_ = 0;
 
-        std::function<void(async_connect_server *const, const SOCKET)> on_connect_callback = {}, on_disconnect_callback_ = {};
-        std::function<void(async_connect_server *const)> on_stop_callback_ = {};
+        std::uint32_t handler_threads_ = 0;
+        std::size_t handler_backlog_ = 0;
+        net::worker_pool handler_pool_ = {};
 
-        std::function<void(async_connect_server *const, const SOCKET, const packet::packet_id, packet::detail::serializer &)> process_callback_ = {};
+        SOCKET server_socket_ = INVALID_SOCKET;
 
-        std::thread accepting_thread_ = {}, processing_thread_ = {}, receiving_thread_ = {}, heartbeat_thread_{};
+        std::vector<std::unique_ptr<reactor>> reactors_ = {};
 
-        packet::detail::serializer serializer = {};
+        std::shared_mutex groups_mtx_ = {};
+        std::unordered_map<std::string, std::unordered_set<connection_id>, string_hash, std::equal_to<>> groups_ = {};
+        std::unordered_map<connection_id, std::vector<std::string>> client_groups_ = {};
+
+        std::function<void(async_connect_server *const, const connection_id)> on_connect_callback = {}, on_disconnect_callback_ = {};
+        std::function<void(async_connect_server *const)> on_stop_callback_ = {};
+        std::function<void(async_connect_server *const, const connection_id, const bool)> on_backpressure_callback_ = {};
+
+        std::function<void(async_connect_server *const, const connection_id, const packet::packet_id, packet::detail::serializer &)> process_callback_ = {};
+        packet::dispatch_table<async_connect_server *, connection_id> handlers_ = {};
+        std::atomic<std::uint64_t> unknown_packets_ = 0;
+        std::atomic<std::uint64_t> accepted_connections_ = 0, failed_handshakes_ = 0;
+        std::function<void(async_connect_server *const, const connection_id, const packet::call_id, const packet::packet_id, packet::detail::serializer &)> request_callback_ = {};
 
     public:
         class exception : public std::exception
@@ -88,7 +474,10 @@ namespace acc
                 null_callback,
                 no_callback,
                 bind_error,
-                listen_error
+                listen_error,
+                event_loop_failure,
+                invalid_reactor_count,
+                invalid_limits
             };
 
             exception(reason_id reason, std::string_view what) : reason_(reason), what_(what){};
@@ -110,4 +499,4 @@ namespace acc
     };
 }
 
-#endif
\ No newline at end of file
+#endif